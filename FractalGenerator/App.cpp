@@ -11,6 +11,10 @@
 
 #include "App.h"
 
+#include <cstdio>
+#include <algorithm>
+#include <sstream>
+
 App::App()
 {
     // Initialize performance frequency
@@ -18,11 +22,27 @@ App::App()
     {
         MessageBox(NULL, _T("QueryPerformanceFrequency failed!"), NULL, NULL);
     }
+
+    // Pick the widest kernels the CPU supports for the Auto language
+    m_cpu = DetectCpuFeatures();
+    if (m_cpu.avx512f && m_cpu.HasAVX())
+    {
+        m_autoLanguage = ID_LANGUAGE_AVX512_MT;
+    }
+    else if (m_cpu.HasAVX())
+    {
+        m_autoLanguage = ID_LANGUAGE_AVX_MT;
+    }
+    else if (m_cpu.sse41)
+    {
+        m_autoLanguage = ID_LANGUAGE_SSE_MT;
+    }
 }
 
 App::~App()
 {
-    _aligned_free(m_pixelBuffer);
+    // The render thread works in the frames
+    m_renderThread.reset();
 }
 
 int App::Run(HINSTANCE hInstance, int nCmdShow)
@@ -88,9 +108,37 @@ int App::Run(HINSTANCE hInstance, int nCmdShow)
         MessageBox(m_hWnd, _T("Failed to load menu."), _T("Error"), MB_OK | MB_ICONERROR);
     }
 
+    // Languages this CPU can't run can't be picked
+    // AVX-512 still leans on the AVX kernels for deep zooms, so it needs both
+    if (hMenu)
+    {
+        if (!m_cpu.sse41)
+        {
+            EnableMenuItem(hMenu, ID_LANGUAGE_SSE, MF_GRAYED);
+            EnableMenuItem(hMenu, ID_LANGUAGE_SSE_MT, MF_GRAYED);
+        }
+
+        if (!m_cpu.HasAVX())
+        {
+            EnableMenuItem(hMenu, ID_LANGUAGE_AVX, MF_GRAYED);
+            EnableMenuItem(hMenu, ID_LANGUAGE_AVX_MT, MF_GRAYED);
+        }
+
+        if (!m_cpu.avx512f || !m_cpu.HasAVX())
+        {
+            EnableMenuItem(hMenu, ID_LANGUAGE_AVX512, MF_GRAYED);
+            EnableMenuItem(hMenu, ID_LANGUAGE_AVX512_MT, MF_GRAYED);
+        }
+    }
+
     // Store pointer to this instance in window's user data
     SetWindowLongPtr(m_hWnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
 
+    m_renderThread = std::make_unique<RenderThread>([this](const std::vector<RenderThread::ViewChange>& changes)
+    {
+        return RenderFrame(changes);
+    });
+
     ShowWindow(m_hWnd,
         nCmdShow);
     UpdateWindow(m_hWnd);
@@ -108,17 +156,504 @@ int App::Run(HINSTANCE hInstance, int nCmdShow)
 
 UINT App::GetLanguage()
 {
-    return m_menuOptionsOn.m_language;
+    // The fractals only ever see a concrete language
+    if (m_frameOptions.m_language == ID_LANGUAGE_AUTO)
+    {
+        return m_autoLanguage;
+    }
+
+    return m_frameOptions.m_language;
 }
 
 UINT App::GetFractal()
 {
-    return m_menuOptionsOn.m_fractal;
+    return m_frameOptions.m_fractal;
 }
 
 UINT App::GetGradient()
 {
-    return m_menuOptionsOn.m_gradient;
+    return m_frameOptions.m_gradient;
+}
+
+double App::GetExponent()
+{
+    switch (m_frameOptions.m_exponent)
+    {
+    case ID_EXPONENT_1_5:
+    {
+        return 1.5;
+    }
+    case ID_EXPONENT_2_5:
+    {
+        return 2.5;
+    }
+    case ID_EXPONENT_3_5:
+    {
+        return 3.5;
+    }
+    case ID_EXPONENT_4_5:
+    {
+        return 4.5;
+    }
+    default:
+    {
+        // The whole powers are numbered in order
+        return 2.0 + (m_frameOptions.m_exponent - ID_EXPONENT_2);
+    }
+    } // Switch
+}
+
+bool App::GetStreaming()
+{
+    return m_frameOptions.m_streaming;
+}
+
+bool App::GetSubdivide()
+{
+    return m_frameOptions.m_subdivide;
+}
+
+bool App::GetReuse()
+{
+    return m_frameOptions.m_reuse;
+}
+
+bool App::GetProgressive()
+{
+    return m_frameOptions.m_progressive;
+}
+
+ThreadPool& App::GetThreadPool()
+{
+    return m_threadPool;
+}
+
+void App::ShowPass()
+{
+    // Called from the render thread between passes, the UI thread paints the copy when it gets to
+    // the WM_PAINT, by which time the frame may be on its next pass or given up
+    if (m_hWnd)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_passMutex);
+            std::copy(m_passFrame, m_passFrame + m_passPixels.size(), m_passPixels.begin());
+        }
+        m_bPass = true;
+        InvalidateRect(m_hWnd, NULL, FALSE);
+    }
+}
+
+bool App::IsRenderStale()
+{
+    return m_renderThread && m_renderThread->IsStale();
+}
+
+std::unique_ptr<Fractal> App::CreateFractal()
+{
+    switch (m_frameOptions.m_fractal)
+    {
+    case ID_FRACTAL_BURNINGSHIP:
+    {
+        return std::make_unique<BurningShip>(shared_from_this());
+    }
+    case ID_FRACTAL_MULTIBROT:
+    {
+        return std::make_unique<Multibrot>(shared_from_this(), GetExponent());
+    }
+    case ID_FRACTAL_NOVA:
+    {
+        return std::make_unique<Nova>(shared_from_this());
+    }
+    case ID_FRACTAL_PHEONIX:
+    {
+        return std::make_unique<Pheonix>(shared_from_this());
+    }
+    default:
+    {
+        return std::make_unique<Mandelbrot>(shared_from_this());
+    }
+    } // Switch
+}
+
+void App::Submit(const RenderThread::ViewChange& change)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_optionsMutex);
+        m_submittedOptions = m_menuOptionsOn;
+    }
+
+    m_renderThread->Submit(change);
+}
+
+bool App::RenderFrame(const std::vector<RenderThread::ViewChange>& changes)
+{
+    // The pool workers are idle between frames, so they all see the same options for this one
+    {
+        std::lock_guard<std::mutex> lock(m_optionsMutex);
+        m_frameOptions = m_submittedOptions;
+    }
+
+    // Every change is applied, even when the frames they were queued for never got rendered
+    bool render = false;
+    for (const RenderThread::ViewChange& change : changes)
+    {
+        switch (change.change)
+        {
+        case RenderThread::Change::GENERATE:
+        {
+            // Resetting the complex plane zoom size with a new fractal
+            std::unique_ptr<Fractal> fractal = CreateFractal();
+
+            std::lock_guard<std::mutex> lock(m_fractalMutex);
+            m_fractal = std::move(fractal);
+            render = true;
+            break;
+        }
+        case RenderThread::Change::ZOOM_IN:
+        case RenderThread::Change::ZOOM_OUT:
+        {
+            if (m_fractal)
+            {
+                m_fractal->ZoomScreen(change.change == RenderThread::Change::ZOOM_IN ?
+                    Fractal::ZoomType::ZOOM_IN : Fractal::ZoomType::ZOOM_OUT);
+                render = true;
+            }
+            break;
+        }
+        case RenderThread::Change::MOVE:
+        {
+            if (m_fractal)
+            {
+                POINT point = change.point;
+                m_fractal->MoveScreen(&point);
+                render = true;
+            }
+            break;
+        }
+        case RenderThread::Change::RECOLOUR:
+        {
+            break;
+        }
+        } // Switch
+    }
+
+    if (!m_fractal)
+    {
+        return true;
+    }
+
+    // Waits here if the window and the encoder still have every other frame
+    Colour* frame = m_frames.Acquire();
+    m_passFrame = frame;
+
+    if (render)
+    {
+        // Given up for a newer view, that view's frame comes straight after
+        if (!m_fractal->Render(frame))
+        {
+            m_frames.Release(frame);
+            return false;
+        }
+    }
+    else
+    {
+        // Only the colours change, the last render's iteration counts are coloured again
+        m_fractal->Recolour(frame);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_fractalMutex);
+        m_renderStats = m_fractal->GetRenderStats();
+    }
+
+    // Only finished frames are recorded, the encoder takes its own copy
+    // Indexed recordings take the counts' colour table entries instead, so they're never quantised
+    if (m_gifEncoder.IsRecording())
+    {
+        if (m_gifEncoder.IsIndexed())
+        {
+            const GifColours& colours = m_fractal->IndexColours(m_indexFrame.data());
+            m_gifEncoder.PushIndexed(m_indexFrame.data(), colours.palette, colours.transparent);
+        }
+        else
+        {
+            m_gifEncoder.Push(frame);
+        }
+    }
+
+    m_frames.Publish(frame);
+
+    if (m_hWnd)
+    {
+        PostMessage(m_hWnd, WM_RENDERED, 0, 0);
+    }
+
+    return true;
+}
+
+void App::BenchmarkLzw()
+{
+    if (!m_fractal)
+    {
+        return;
+    }
+
+    // The render thread is idle, so the last frame's counts can be read from here
+    const GifColours& colours = m_fractal->IndexColours(m_indexFrame.data());
+    const int numPixels = m_widthW * m_heightW;
+    const int reps = 20;
+
+    FILE* sink = tmpfile();
+    if (!sink)
+    {
+        return;
+    }
+
+    GifLzwEncoder encoder;
+    GifLzwInit(&encoder);
+
+    LARGE_INTEGER start, end;
+    double bitwiseMs = 0.0, packedMs = 0.0;
+    for (int i = 0; i < reps; ++i)
+    {
+        rewind(sink);
+        QueryPerformanceCounter(&start);
+        GifWriteLzwDataBitwise(sink, m_indexFrame.data(), 1, m_widthW, m_heightW, colours.palette.bitDepth);
+        QueryPerformanceCounter(&end);
+        bitwiseMs += static_cast<double>(end.QuadPart - start.QuadPart) * 1000.0 / m_liFrequency.QuadPart;
+
+        rewind(sink);
+        QueryPerformanceCounter(&start);
+        GifWriteLzwData(sink, &encoder, m_indexFrame.data(), 1, m_widthW, m_heightW, colours.palette.bitDepth);
+        QueryPerformanceCounter(&end);
+        packedMs += static_cast<double>(end.QuadPart - start.QuadPart) * 1000.0 / m_liFrequency.QuadPart;
+    }
+
+    // MB/s of palette indices in, a byte a pixel
+    const double megabytes = static_cast<double>(numPixels) * reps / 1e6;
+    printf("  lzw: %d bytes a frame, bit at a time %.1f MB/s (%.2f ms), packed %.1f MB/s (%.2f ms)\n",
+        static_cast<int>(encoder.size), megabytes * 1000.0 / bitwiseMs, bitwiseMs / reps, megabytes * 1000.0 / packedMs, packedMs / reps);
+
+    GifLzwFree(&encoder);
+    fclose(sink);
+}
+
+int App::CheckLzw()
+{
+    // Images that end bands with the dictionary on the edge of a wider code: rows of distinct
+    // indices, noise at every bit depth, and the last frame's colour table entries if there is one
+    struct Image
+    {
+        std::vector<uint8_t> indices;
+        int width, height, bitDepth;
+    };
+    std::vector<Image> images;
+
+    for (int height : { 2, kGifMaxBands })
+    {
+        for (int width : { 127, 255, 256, 511 })
+        {
+            Image distinct{ std::vector<uint8_t>(width * height), width, height, 8 };
+            for (size_t i = 0; i < distinct.indices.size(); ++i)
+            {
+                distinct.indices[i] = static_cast<uint8_t>(i % width % 255);
+            }
+            images.push_back(std::move(distinct));
+        }
+    }
+
+    uint32_t seed = 1;
+    for (int bitDepth = 1; bitDepth <= 8; ++bitDepth)
+    {
+        Image noise{ std::vector<uint8_t>(m_widthW * m_heightW), m_widthW, m_heightW, bitDepth };
+        for (uint8_t& index : noise.indices)
+        {
+            seed = seed * 1103515245 + 12345;
+            index = static_cast<uint8_t>((seed >> 16) & ((1 << bitDepth) - 1));
+        }
+        images.push_back(std::move(noise));
+    }
+
+    if (m_fractal)
+    {
+        const GifColours& colours = m_fractal->IndexColours(m_indexFrame.data());
+        images.push_back({ m_indexFrame, m_widthW, m_heightW, colours.palette.bitDepth });
+    }
+
+    GifLzwEncoder encoder;
+    GifLzwEncoder bandEncoders[kGifMaxBands - 1];
+    GifLzwInit(&encoder);
+    for (GifLzwEncoder& bandEncoder : bandEncoders)
+    {
+        GifLzwInit(&bandEncoder);
+    }
+
+    int checked = 0, failed = 0;
+    std::vector<uint8_t> decoded;
+    for (const Image& image : images)
+    {
+        for (int bands = 1; bands <= kGifMaxBands; ++bands)
+        {
+            GifLzwEncodeBands(&encoder, bandEncoders, bands, &m_gifPool, image.indices.data(), 1, image.width, image.height, image.bitDepth);
+
+            decoded.assign(image.indices.size(), 0);
+            if (!GifLzwDecode(encoder.data, encoder.size, decoded.data(), decoded.size()) || decoded != image.indices)
+            {
+                printf("  lzw: %dx%d at %d bits in %d bands doesn't decode\n", image.width, image.height, image.bitDepth, bands);
+                ++failed;
+            }
+            ++checked;
+        }
+    }
+    printf("  lzw: %d of %d images decoded\n", checked - failed, checked);
+
+    for (GifLzwEncoder& bandEncoder : bandEncoders)
+    {
+        GifLzwFree(&bandEncoder);
+    }
+    GifLzwFree(&encoder);
+
+    return failed;
+}
+
+int App::RunHeadless(const std::string& script)
+{
+    // Report to the console this was started from, if there is one
+    if (AttachConsole(ATTACH_PARENT_PROCESS))
+    {
+        FILE* console = nullptr;
+        freopen_s(&console, "CONOUT$", "w", stdout);
+    }
+
+    m_renderThread = std::make_unique<RenderThread>([this](const std::vector<RenderThread::ViewChange>& changes)
+    {
+        return RenderFrame(changes);
+    });
+
+    LARGE_INTEGER start, end;
+    QueryPerformanceCounter(&start);
+
+    // Images lzwcheck couldn't get back, the exit code
+    int failures = 0;
+
+    std::istringstream words(script);
+    std::string word;
+    while (words >> word)
+    {
+        RenderThread::ViewChange change{};
+
+        if (word == "generate")
+        {
+            change.change = RenderThread::Change::GENERATE;
+        }
+        else if (word == "in" || word == "out")
+        {
+            change.change = word == "in" ? RenderThread::Change::ZOOM_IN : RenderThread::Change::ZOOM_OUT;
+        }
+        else if (word.rfind("move:", 0) == 0 && sscanf_s(word.c_str() + 5, "%ld,%ld", &change.point.x, &change.point.y) == 2)
+        {
+            change.change = RenderThread::Change::MOVE;
+        }
+        else if (word == "wait")
+        {
+            m_renderThread->Wait();
+
+            QueryPerformanceCounter(&end);
+            double ms = static_cast<double>(end.QuadPart - start.QuadPart) * 1000.0 / m_liFrequency.QuadPart;
+            printf("%.2f ms: %d frames rendered, %d given up\n", ms,
+                m_renderThread->GetFinishedFrames(), m_renderThread->GetCancelledFrames());
+
+            if (m_bRecording)
+            {
+                GifEncoder::Stats gif = m_gifEncoder.GetStats();
+                printf("  gif: %d/%d queued, %d written, %d dropped, %.2f ms to encode, %.2f ms queued to written, %.1f%% colour cache hits\n",
+                    gif.queued, gif.capacity, gif.encoded, gif.dropped, gif.meanEncodeMs, gif.meanLatencyMs, gif.cacheHitRate);
+            }
+            continue;
+        }
+        else if (word == "lzwbench")
+        {
+            m_renderThread->Wait();
+            BenchmarkLzw();
+            continue;
+        }
+        else if (word == "lzwcheck")
+        {
+            m_renderThread->Wait();
+            failures += CheckLzw();
+            continue;
+        }
+        else if (word.rfind("record:", 0) == 0)
+        {
+            m_renderThread->Wait();
+
+            m_gifEncoder.SetPolicy(m_menuOptionsOn.m_gifDrop ? GifEncoder::Policy::DROP : GifEncoder::Policy::WAIT);
+            m_bRecording = m_gifEncoder.Begin(word.c_str() + 7, m_widthW, m_heightW, m_gifDelay, m_gifQueueDepth, m_menuOptionsOn.m_gifIndexed);
+            continue;
+        }
+        else if (word == "stoprecord")
+        {
+            m_renderThread->Wait();
+
+            m_gifEncoder.End();
+            m_bRecording = false;
+            continue;
+        }
+        else
+        {
+            if (word == "stream")
+            {
+                m_menuOptionsOn.m_streaming = !m_menuOptionsOn.m_streaming;
+            }
+            else if (word == "subdivide")
+            {
+                m_menuOptionsOn.m_subdivide = !m_menuOptionsOn.m_subdivide;
+            }
+            else if (word == "reuse")
+            {
+                m_menuOptionsOn.m_reuse = !m_menuOptionsOn.m_reuse;
+            }
+            else if (word == "progressive")
+            {
+                m_menuOptionsOn.m_progressive = !m_menuOptionsOn.m_progressive;
+            }
+            else if (word == "gifdrop")
+            {
+                m_menuOptionsOn.m_gifDrop = !m_menuOptionsOn.m_gifDrop;
+                m_gifEncoder.SetPolicy(m_menuOptionsOn.m_gifDrop ? GifEncoder::Policy::DROP : GifEncoder::Policy::WAIT);
+            }
+            else if (word == "gifsample")
+            {
+                m_menuOptionsOn.m_gifSample = !m_menuOptionsOn.m_gifSample;
+                m_gifEncoder.SetPaletteStep(m_menuOptionsOn.m_gifSample ? m_gifPaletteStep : 1);
+            }
+            else if (word == "gifindexed")
+            {
+                m_menuOptionsOn.m_gifIndexed = !m_menuOptionsOn.m_gifIndexed;
+            }
+            else if (word == "gifbands")
+            {
+                m_menuOptionsOn.m_gifBands = !m_menuOptionsOn.m_gifBands;
+                m_gifEncoder.SetBands(m_menuOptionsOn.m_gifBands ? static_cast<int>(m_gifPool.GetNumThreads()) : 1);
+            }
+            else
+            {
+                printf("Unknown command %s\n", word.c_str());
+            }
+
+            // Options go to the render thread with the next change submitted, wait so the frames around the toggle have finished
+            m_renderThread->Wait();
+            continue;
+        }
+
+        Submit(change);
+    }
+
+    m_renderThread->Wait();
+    m_renderThread.reset();
+    m_gifEncoder.End();
+
+    return failures;
 }
 
 LRESULT CALLBACK App::StaticWndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
@@ -158,10 +693,15 @@ LRESULT App::WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
     {
         auto hdc = BeginPaint(hWnd, &m_ps);
 
+        // The render thread only swaps the fractal under the lock
+        std::unique_lock<std::mutex> lock(m_fractalMutex);
+
         if (m_bRender)
         {
-            // Transfer off-screen bitmap onto the window
-            m_fractal->Draw(hdc, m_pixelBuffer, &m_gif, m_bRecording);
+            // Transfer the front frame onto the window, held so it isn't rendered over half way
+            Colour* front = m_frames.AcquireFront();
+            m_fractal->Draw(hdc, front);
+            m_frames.Release(front);
             // The image has been generated to the window
             m_bCanZoom = true;
 
@@ -174,12 +714,42 @@ LRESULT App::WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                 double dSeconds = static_cast<double>(m_liTicks.QuadPart) / m_liFrequency.QuadPart;
                 std::wstring strText = std::format(L"{:.2f} ms", dSeconds * 1000);
 
+                const Fractal::RenderStats& stats = m_renderStats;
+                std::wstring strStats = std::format(L"{} tiles, slowest {:.2f} ms, avg {:.2f} ms, imbalance {:.2f}",
+                    stats.numTiles, stats.maxTileMs, stats.meanTileMs, stats.workerImbalance);
+                std::wstring strSkips = std::format(L"{} px in cardioid/bulb, {} px periodic, {} px filled, {} px reused",
+                    stats.cardioidSkips, stats.periodicSkips, stats.subdivideFills, stats.reusedPixels);
+                if (stats.references > 0)
+                {
+                    strSkips += std::format(L"  |  deep zoom: {} reference orbits, {} px glitched, {} iterations skipped by series",
+                        stats.references, stats.glitchedPixels, stats.seriesSkip);
+                }
+
+                TextOut(hdc, 0, m_heightW - 115, strSkips.c_str(), static_cast<int>(strSkips.length()));
+                TextOut(hdc, 0, m_heightW - 97, strStats.c_str(), static_cast<int>(strStats.length()));
                 TextOut(hdc, 0, m_heightW - 79, strText.c_str(), static_cast<int>(strText.length()));
 
                 m_bTimer = false;
             }
 
+            if (m_bRecording)
+            {
+                GifEncoder::Stats gif = m_gifEncoder.GetStats();
+                std::wstring strGif = std::format(L"gif: {}/{} queued, {} written, {} dropped, {:.2f} ms to encode, {:.2f} ms queued to written, {:.1f}% colour cache hits",
+                    gif.queued, gif.capacity, gif.encoded, gif.dropped, gif.meanEncodeMs, gif.meanLatencyMs, gif.cacheHitRate);
+
+                TextOut(hdc, 0, m_heightW - 133, strGif.c_str(), static_cast<int>(strGif.length()));
+            }
+
             m_bRender = false;
+            m_bPass = false;
+        }
+        else if (m_bPass && m_fractal)
+        {
+            // A pass of a progressive render, not the finished image
+            std::lock_guard<std::mutex> passLock(m_passMutex);
+            m_fractal->Draw(hdc, m_passPixels.data());
+            m_bPass = false;
         }
 
         EndPaint(hWnd, &m_ps);
@@ -196,44 +766,8 @@ LRESULT App::WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             m_bTimer = true;
             QueryPerformanceCounter(&m_liStartTime);
 
-            // Render the selected fractal to the pixel buffer
-            // Resetting the complex plane zoom size after generation button
-            switch (m_menuOptionsOn.m_fractal)
-            {
-            case ID_FRACTAL_MANDELBROT:
-            {
-                m_fractal = std::make_unique<Mandelbrot>(shared_from_this());
-                break;
-            }
-            case ID_FRACTAL_BURNINGSHIP:
-            {
-                m_fractal = std::make_unique<BurningShip>(shared_from_this());
-                break;
-            }
-            case ID_FRACTAL_MULTIBROT:
-            {
-                m_fractal = std::make_unique<Multibrot>(shared_from_this());
-                break;
-            }
-            case ID_FRACTAL_NOVA:
-            {
-                m_fractal = std::make_unique<Nova>(shared_from_this());
-                break;
-            }
-            case ID_FRACTAL_PHEONIX:
-            {
-                m_fractal = std::make_unique<Pheonix>(shared_from_this());
-                break;
-            }
-            } // Switch
-
-            // Rendering the mandelbrot to the pixel buffer
-            m_fractal->Render(m_pixelBuffer);
-
-            // Painting to the window
-            // Force a repaint to transfer the bitmap buffer to the window
-            m_bRender = true;
-            InvalidateRect(hWnd, NULL, TRUE);
+            // Render the selected fractal to the pixel buffer, on the render thread
+            Submit({ RenderThread::Change::GENERATE });
 
             break;
         }
@@ -284,25 +818,115 @@ LRESULT App::WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                 filePath /= "output.gif";
                                 
                 // Start adding to the gif
-                GifBegin(&m_gif, filePath.string().c_str(), m_widthW, m_heightW, m_gifDelay);
-                m_bRecording = true;
+                m_gifEncoder.SetPolicy(m_menuOptionsOn.m_gifDrop ? GifEncoder::Policy::DROP : GifEncoder::Policy::WAIT);
+                m_bRecording = m_gifEncoder.Begin(filePath.string().c_str(), m_widthW, m_heightW, m_gifDelay, m_gifQueueDepth, m_menuOptionsOn.m_gifIndexed);
             }
             else
             {
                 SendMessage(hRecButton, WM_SETTEXT, 0, (LPARAM)L"Start Recording");
 
-                GifEnd(&m_gif);
+                // Frames still queued are written before the gif is closed
+                m_gifEncoder.End();
                 m_bRecording = false;
             }
 
             break;
         }
+        case ID_RENDER_STREAM:
+        {
+            HMENU hMenu = GetMenu(hWnd);
+
+            // Toggle the lane refill kernels on/off
+            m_menuOptionsOn.m_streaming = !m_menuOptionsOn.m_streaming;
+            CheckMenuItem(hMenu, ID_RENDER_STREAM, m_menuOptionsOn.m_streaming ? MF_CHECKED : MF_UNCHECKED);
+
+            break;
+        }
+        case ID_RENDER_SUBDIVIDE:
+        {
+            HMENU hMenu = GetMenu(hWnd);
+
+            // Toggle rectangle subdivision (Mariani-Silver) on/off
+            m_menuOptionsOn.m_subdivide = !m_menuOptionsOn.m_subdivide;
+            CheckMenuItem(hMenu, ID_RENDER_SUBDIVIDE, m_menuOptionsOn.m_subdivide ? MF_CHECKED : MF_UNCHECKED);
+
+            break;
+        }
+        case ID_RENDER_REUSE:
+        {
+            HMENU hMenu = GetMenu(hWnd);
+
+            // Toggle copying pixels from the last frame when zooming/moving
+            m_menuOptionsOn.m_reuse = !m_menuOptionsOn.m_reuse;
+            CheckMenuItem(hMenu, ID_RENDER_REUSE, m_menuOptionsOn.m_reuse ? MF_CHECKED : MF_UNCHECKED);
+
+            break;
+        }
+        case ID_RENDER_PROGRESSIVE:
+        {
+            HMENU hMenu = GetMenu(hWnd);
+
+            // Toggle showing coarse passes before the full image on/off
+            m_menuOptionsOn.m_progressive = !m_menuOptionsOn.m_progressive;
+            CheckMenuItem(hMenu, ID_RENDER_PROGRESSIVE, m_menuOptionsOn.m_progressive ? MF_CHECKED : MF_UNCHECKED);
+
+            break;
+        }
+        case ID_RENDER_GIF_DROP:
+        {
+            HMENU hMenu = GetMenu(hWnd);
+
+            // Toggle dropping recorded frames (instead of waiting) while the gif encoder is behind
+            m_menuOptionsOn.m_gifDrop = !m_menuOptionsOn.m_gifDrop;
+            CheckMenuItem(hMenu, ID_RENDER_GIF_DROP, m_menuOptionsOn.m_gifDrop ? MF_CHECKED : MF_UNCHECKED);
+
+            m_gifEncoder.SetPolicy(m_menuOptionsOn.m_gifDrop ? GifEncoder::Policy::DROP : GifEncoder::Policy::WAIT);
+
+            break;
+        }
+        case ID_RENDER_GIF_SAMPLE:
+        {
+            HMENU hMenu = GetMenu(hWnd);
+
+            // Toggle building gif palettes from a sample of the pixels instead of all of them
+            m_menuOptionsOn.m_gifSample = !m_menuOptionsOn.m_gifSample;
+            CheckMenuItem(hMenu, ID_RENDER_GIF_SAMPLE, m_menuOptionsOn.m_gifSample ? MF_CHECKED : MF_UNCHECKED);
+
+            m_gifEncoder.SetPaletteStep(m_menuOptionsOn.m_gifSample ? m_gifPaletteStep : 1);
+
+            break;
+        }
+        case ID_RENDER_GIF_INDEXED:
+        {
+            HMENU hMenu = GetMenu(hWnd);
+
+            // Toggle recording colour table entries straight from the counts, picked up by the next recording
+            m_menuOptionsOn.m_gifIndexed = !m_menuOptionsOn.m_gifIndexed;
+            CheckMenuItem(hMenu, ID_RENDER_GIF_INDEXED, m_menuOptionsOn.m_gifIndexed ? MF_CHECKED : MF_UNCHECKED);
+
+            break;
+        }
+        case ID_RENDER_GIF_BANDS:
+        {
+            HMENU hMenu = GetMenu(hWnd);
+
+            // Toggle compressing each recorded frame in bands, one per gif worker
+            m_menuOptionsOn.m_gifBands = !m_menuOptionsOn.m_gifBands;
+            CheckMenuItem(hMenu, ID_RENDER_GIF_BANDS, m_menuOptionsOn.m_gifBands ? MF_CHECKED : MF_UNCHECKED);
+
+            m_gifEncoder.SetBands(m_menuOptionsOn.m_gifBands ? static_cast<int>(m_gifPool.GetNumThreads()) : 1);
+
+            break;
+        }
         case ID_LANGUAGE_CPP:
         case ID_LANGUAGE_SSE:
         case ID_LANGUAGE_AVX:
+        case ID_LANGUAGE_AVX512:
         case ID_LANGUAGE_CPP_MT:
         case ID_LANGUAGE_SSE_MT:
         case ID_LANGUAGE_AVX_MT:
+        case ID_LANGUAGE_AVX512_MT:
+        case ID_LANGUAGE_AUTO:
         {
             HMENU hMenu = GetMenu(hWnd);
 
@@ -346,6 +970,34 @@ LRESULT App::WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 
             m_menuOptionsOn.m_gradient = param;
 
+            // Only the colours change, the last render's iteration counts are coloured again
+            if (m_bCanZoom)
+            {
+                Submit({ RenderThread::Change::RECOLOUR });
+            }
+
+            break;
+        }
+        case ID_EXPONENT_2:
+        case ID_EXPONENT_3:
+        case ID_EXPONENT_4:
+        case ID_EXPONENT_5:
+        case ID_EXPONENT_6:
+        case ID_EXPONENT_7:
+        case ID_EXPONENT_8:
+        case ID_EXPONENT_1_5:
+        case ID_EXPONENT_2_5:
+        case ID_EXPONENT_3_5:
+        case ID_EXPONENT_4_5:
+        {
+            HMENU hMenu = GetMenu(hWnd);
+
+            // Change checked item, the Multibrot picks it up on the next generate
+            CheckMenuItem(hMenu, m_menuOptionsOn.m_exponent, MF_UNCHECKED);
+            CheckMenuItem(hMenu, param, MF_CHECKED);
+
+            m_menuOptionsOn.m_exponent = param;
+
             break;
         }
         } // Switch
@@ -360,15 +1012,8 @@ LRESULT App::WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             GetCursorPos(&m_clickPoint);
             ScreenToClient(hWnd, &m_clickPoint);
 
-            m_fractal->MoveScreen(&m_clickPoint);
-
-            // Rendering the mandelbrot to the pixel buffer
-            m_fractal->Render(m_pixelBuffer);
-
-            // Painting to the window
-            // Force a repaint to transfer the bitmap buffer to the window
-            m_bRender = true;
-            InvalidateRect(hWnd, NULL, TRUE);
+            // Moving and rendering on the render thread, a frame still in flight is given up
+            Submit({ RenderThread::Change::MOVE, m_clickPoint });
         }
 
         break;
@@ -380,22 +1025,26 @@ LRESULT App::WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             int wheelDelta = GET_WHEEL_DELTA_WPARAM(wParam);
 
             // Scrolling up/down (zoomin in/out)
-            m_fractal->ZoomScreen(wheelDelta > 0 ? 
-                Fractal::ZoomType::ZOOM_IN : Fractal::ZoomType::ZOOM_OUT);
-
-            // Rendering the mandelbrot to the pixel buffer
-            m_fractal->Render(m_pixelBuffer);
-
-            // Painting to the window
-            // Force a repaint to transfer the bitmap buffer to the window
-            m_bRender = true;
-            InvalidateRect(hWnd, NULL, TRUE);
+            // A burst of wheel events is queued up and rendered as one frame
+            Submit({ wheelDelta > 0 ? RenderThread::Change::ZOOM_IN : RenderThread::Change::ZOOM_OUT });
         }
 
         break;
     }
+    case WM_RENDERED:
+    {
+        // Painting to the window
+        // Force a repaint to transfer the bitmap buffer to the window
+        m_bRender = true;
+        InvalidateRect(hWnd, NULL, TRUE);
+
+        break;
+    }
     case WM_DESTROY:
     {
+        // Stop rendering before the window goes
+        m_renderThread.reset();
+
         PostQuitMessage(0);
         break;
     }
@@ -417,5 +1066,13 @@ int WINAPI WinMain(
 {
     auto app = std::make_shared<App>();
 
+    // FractalGenerator.exe /headless generate in in wait ...
+    const std::string headless = "/headless";
+    std::string commandLine = lpStr ? lpStr : "";
+    if (commandLine.rfind(headless, 0) == 0)
+    {
+        return app->RunHeadless(commandLine.substr(headless.size()));
+    }
+
     return app->Run(hInstance, nCmdShow);
 }
\ No newline at end of file
@@ -19,7 +19,13 @@
 #include <memory>
 #include <stdint.h>
 #include <filesystem>
+#include <string>
 #include "Resource.h"
+#include "ThreadPool.h"
+#include "RenderThread.h"
+#include "FrameRing.h"
+#include "GifEncoder.h"
+#include "CpuFeatures.h"
 #include "Fractals/Fractal.h"
 #include "Fractals/Fractals.h"
 
@@ -34,6 +40,12 @@ public:
 
     int m_gifDelay = 10;
 
+    // Frames the gif encoder may have queued before the policy kicks in
+    int m_gifQueueDepth = 8;
+
+    // Sampling builds each gif palette from every this many pixels
+    int m_gifPaletteStep = 4;
+
 private:
     // Window variables
     HWND m_hWnd{};
@@ -50,24 +62,79 @@ private:
     // App menu variables
     struct MenuOptions
     {
-        UINT m_language = ID_LANGUAGE_CPP;
+        UINT m_language = ID_LANGUAGE_AUTO;
         UINT m_fractal = ID_FRACTAL_MANDELBROT;
         UINT m_gradient = ID_GRADIENT_1;
-    } m_menuOptionsOn;
+        UINT m_exponent = ID_EXPONENT_5;
+        bool m_streaming = false;
+        bool m_subdivide = false;
+        bool m_reuse = false;
+        bool m_progressive = false;
+        bool m_gifDrop = false;
+        bool m_gifSample = false;
+        bool m_gifIndexed = false;
+        bool m_gifBands = false;
+    } m_menuOptionsOn; // UI thread only
+
+    // A frame is rendered with the options as they were when its last change was submitted, so
+    // a menu change can't land part way through one. The getters read m_frameOptions, which only
+    // the render thread writes, before the frame starts
+    std::mutex m_optionsMutex;
+    MenuOptions m_submittedOptions;
+    MenuOptions m_frameOptions;
 
     // App related variables
     bool m_bRender{};
     bool m_bTimer{};
     bool m_bCanZoom{};
     bool m_bRecording{};
+    std::atomic<bool> m_bPass{}; // Set from the render thread
 
     // WndProc variables
     PAINTSTRUCT m_ps{};
     POINT m_clickPoint{};
-    Colour* m_pixelBuffer = (Colour*)_aligned_malloc(sizeof(Colour) * m_widthW * m_heightW, 32);
-    GifWriter m_gif = { NULL, NULL, NULL };
     std::unique_ptr<Fractal> m_fractal;
 
+    // The render thread renders into one frame while the window shows another
+    // Three, so a frame being painted doesn't hold up the render either
+    FrameRing m_frames{ 3, m_widthW * m_heightW };
+    Colour* m_passFrame{}; // The frame a progressive render is part way through (render thread only)
+
+    // Each finished pass is copied here for the window, the render thread carries on into the frame
+    std::mutex m_passMutex;
+    std::vector<Colour> m_passPixels = std::vector<Colour>(m_widthW * m_heightW);
+
+    // Colour table entries of the last frame, for indexed recordings (render thread only)
+    std::vector<uint8_t> m_indexFrame = std::vector<uint8_t>(m_widthW * m_heightW);
+
+    // Render workers, created once and reused for every frame
+    ThreadPool m_threadPool;
+
+    // Workers for the gif encoder's palette splits and LZW bands, apart from the render workers
+    // so a render waiting on its tiles never picks up gif work (or the encoder render tiles)
+    ThreadPool m_gifPool;
+
+    // Recorded frames are copied to the encoder's queue and written on its own thread
+    // It uses its own workers, so it comes after them
+    GifEncoder m_gifEncoder{ m_gifPool };
+
+    // What this machine can run, checked once at startup
+    // Auto resolves to the widest kernel family on the list, multithreaded
+    CpuFeatures m_cpu;
+    UINT m_autoLanguage = ID_LANGUAGE_CPP_MT;
+
+    // Frames are rendered on their own thread so input keeps coming in
+    // The UI thread only swaps m_fractal for a new one (on the render thread) under the mutex,
+    // and reads the stats of the last finished frame from the copy kept here
+    std::mutex m_fractalMutex;
+    Fractal::RenderStats m_renderStats{};
+
+    // Posted by the render thread when a frame is ready to paint
+    static const UINT WM_RENDERED = WM_APP + 1;
+
+    // Last so it's stopped before anything it renders with goes away
+    std::unique_ptr<RenderThread> m_renderThread;
+
 public:
     App();
 
@@ -80,8 +147,42 @@ public:
     UINT GetLanguage();
     UINT GetFractal();
     UINT GetGradient();
+    double GetExponent();
+    bool GetStreaming();
+    bool GetSubdivide();
+    bool GetReuse();
+    bool GetProgressive();
+    ThreadPool& GetThreadPool();
+
+    // Painting a pass of a progressive render while the rest of it is still being computed
+    void ShowPass();
+
+    // Whether the frame being rendered has been overtaken by a newer view
+    bool IsRenderStale();
+
+    // Rendering a script of view changes with no window, for timing and testing
+    // Words separated by spaces: generate, in, out, move:x,y, wait, record:file, stoprecord,
+    // lzwbench, lzwcheck, and the stream/subdivide/reuse/progressive/gifdrop/gifsample/gifindexed/gifbands toggles
+    int RunHeadless(const std::string& script);
 
 private:
+    // The fractal selected on the menu, with its starting view
+    std::unique_ptr<Fractal> CreateFractal();
+
+    // Queueing a view change for the render thread along with the options to render it with
+    void Submit(const RenderThread::ViewChange& change);
+
+    // Applying view changes and rendering them, on the render thread
+    bool RenderFrame(const std::vector<RenderThread::ViewChange>& changes);
+
+    // Timing the gif LZW encoder against the original bit at a time one, on the last frame's
+    // colour table entries (headless lzwbench)
+    void BenchmarkLzw();
+
+    // Compressing images in 1 to kGifMaxBands bands and decoding them again, returning how many
+    // didn't come back exactly (headless lzwcheck)
+    int CheckLzw();
+
     // Static WndProc callback
     static LRESULT CALLBACK StaticWndProc(HWND, UINT, WPARAM, LPARAM);
 
@@ -0,0 +1,50 @@
+/*********************************************************************************************
+**
+**	File Name:		CpuFeatures.cpp
+**	Description:	This is the file that contains the CPUID check for the SIMD kernel families
+**
+**	Author:			Clarke Needles
+**	Created:		10/17/2026
+**
+**********************************************************************************************/
+
+#include "CpuFeatures.h"
+
+#include <intrin.h>
+#include <immintrin.h>
+
+CpuFeatures DetectCpuFeatures()
+{
+    CpuFeatures features;
+
+    int info[4]; // EAX, EBX, ECX, EDX
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+
+    if (maxLeaf < 1)
+    {
+        return features;
+    }
+
+    __cpuid(info, 1);
+    features.sse41 = (info[2] & (1 << 19)) != 0;
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+
+    // The CPU having AVX isn't enough, the OS has to save the YMM (and ZMM) state too
+    unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+    const bool osYmm = (xcr0 & 0x6) == 0x6;    // SSE and AVX state
+    const bool osZmm = (xcr0 & 0xE6) == 0xE6;  // Plus the opmask and both halves of ZMM
+
+    if (maxLeaf >= 7)
+    {
+        __cpuidex(info, 7, 0);
+        features.avx2 = avx && osYmm && (info[1] & (1 << 5)) != 0;
+        features.avx512f = osZmm && (info[1] & (1 << 16)) != 0;
+    }
+
+    features.fma = fma && osYmm;
+
+    return features;
+}
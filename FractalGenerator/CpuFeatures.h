@@ -0,0 +1,29 @@
+/*********************************************************************************************
+**
+**	File Name:		CpuFeatures.h
+**	Description:	This is the header file that contains the CPUID check for which SIMD
+**                  kernel families the machine (and the OS) can run
+**
+**	Author:			Clarke Needles
+**	Created:		10/17/2026
+**
+**********************************************************************************************/
+
+#pragma once
+
+struct CpuFeatures
+{
+    bool sse41 = false;
+    bool avx2 = false;
+    bool fma = false;
+    bool avx512f = false;
+
+    // The AVX kernels are compiled for AVX2 + FMA, treat them as one feature
+    bool HasAVX() const
+    {
+        return avx2 && fma;
+    }
+};
+
+// Checks CPUID, and XGETBV for whether the OS saves the wider registers on a context switch
+CpuFeatures DetectCpuFeatures();
@@ -11,27 +11,33 @@
 
 #pragma once
 
-#include "Fractal.h"
+#include "FractalKernels.h"
 
-class BurningShip : public Fractal
+class BurningShip : public FractalKernels<BurningShip>
 {
 private:
-    int GetCPPIterF(float xval, float yval) const override;
+    friend class FractalKernels<BurningShip>;
 
-    int GetCPPIterD(double xval, double yval) const override;
-
-    __m128i GetSSEIterF(__m128 xval, __m128 yval) const override;
-
-    __m128i GetSSEIterD(__m128d xval, __m128d yval) const override;
-
-    __m256i GetAVXIterF(__m256 xval, __m256 yval) const override;
+    // One iteration written once for every register width, every kernel family is built from it
+    struct Formula
+    {
+        template<class V>
+        static void Step(Orbit<V>& z, typename V::Reg cx, typename V::Reg cy);
+    };
 
-    __m256i GetAVXIterD(__m256d xval, __m256d yval) const override;
+    // The same iteration in double-double, for views too small for doubles
+    struct FormulaDD
+    {
+        template<class V>
+        static void Step(OrbitDD<V>& z, const DD<V>& cx, const DD<V>& cy);
+    };
 
 public:
-    BurningShip(std::shared_ptr<App> app) : Fractal(app, -2.2, 1.4, -2.1, 1.2)
+    BurningShip(std::shared_ptr<App> app) : FractalKernels(app, -2.2, 1.4, -2.1, 1.2)
     {
     }
 
     ~BurningShip() {}
-};
\ No newline at end of file
+};
+
+extern template class FractalKernels<BurningShip>;
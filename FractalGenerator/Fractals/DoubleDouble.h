@@ -0,0 +1,321 @@
+/*********************************************************************************************
+**
+**	File Name:		doubledouble.h
+**	Description:	This is the header file that contains double-double arithmetic (a number
+**                  kept as an unevaluated sum hi + lo of two doubles, about 106 bits) for every
+**                  register width, and the streaming kernel built on top of it
+**
+**	Author:			Clarke Needles
+**	Created:		10/17/2026
+**
+**********************************************************************************************/
+
+#pragma once
+
+#include <bit>
+#include <cstring>
+#include "Simd.h"
+
+// One double-double per lane
+template<class V>
+struct DD
+{
+    typename V::Reg hi, lo;
+};
+
+// Error free transformations, a + b and a * b come out exactly as s + e
+
+// Needs |a| >= |b|
+template<class V>
+inline DD<V> QuickTwoSum(typename V::Reg a, typename V::Reg b)
+{
+    auto s = V::Add(a, b);
+    return { s, V::Sub(b, V::Sub(s, a)) };
+}
+
+template<class V>
+inline DD<V> TwoSum(typename V::Reg a, typename V::Reg b)
+{
+    auto s = V::Add(a, b);
+    auto bb = V::Sub(s, a);
+    return { s, V::Add(V::Sub(a, V::Sub(s, bb)), V::Sub(b, bb)) };
+}
+
+// Splits a into two halves of 26 bits, their products with each other are exact
+template<class V>
+inline DD<V> Split(typename V::Reg a)
+{
+    auto t = V::Mul(V::Set1(134217729.0), a); // 2^27 + 1
+    auto hi = V::Sub(t, V::Sub(t, a));
+    return { hi, V::Sub(a, hi) };
+}
+
+// With an FMA the rounding error of the product is one instruction, otherwise (SSE) it's Dekker's
+// product of the halves
+template<class V>
+inline DD<V> TwoProd(typename V::Reg a, typename V::Reg b)
+{
+    auto p = V::Mul(a, b);
+    if constexpr (requires { V::Fms(a, b, p); })
+    {
+        return { p, V::Fms(a, b, p) };
+    }
+    else
+    {
+        DD<V> as = Split<V>(a), bs = Split<V>(b);
+        auto e = V::Add(V::Sub(V::Mul(as.hi, bs.hi), p), V::Add(V::Mul(as.hi, bs.lo), V::Mul(as.lo, bs.hi)));
+        return { p, V::Add(e, V::Mul(as.lo, bs.lo)) };
+    }
+}
+
+// The escape time loops only ever add values of about the same size, so the quicker add (error
+// relative to |a| + |b| rather than |a + b|) is plenty
+template<class V>
+inline DD<V> Add(const DD<V>& a, const DD<V>& b)
+{
+    DD<V> s = TwoSum<V>(a.hi, b.hi);
+    return QuickTwoSum<V>(s.hi, V::Add(s.lo, V::Add(a.lo, b.lo)));
+}
+
+template<class V>
+inline DD<V> Sub(const DD<V>& a, const DD<V>& b)
+{
+    DD<V> s = TwoSum<V>(a.hi, V::Sub(V::Zero(), b.hi));
+    return QuickTwoSum<V>(s.hi, V::Add(s.lo, V::Sub(a.lo, b.lo)));
+}
+
+template<class V>
+inline DD<V> Mul(const DD<V>& a, const DD<V>& b)
+{
+    DD<V> p = TwoProd<V>(a.hi, b.hi);
+    auto cross = V::Add(V::Mul(a.hi, b.lo), V::Mul(a.lo, b.hi));
+    return QuickTwoSum<V>(p.hi, V::Add(p.lo, cross));
+}
+
+// Times a plain double (constants in the formulas)
+template<class V>
+inline DD<V> Mul(const DD<V>& a, typename V::Reg b)
+{
+    DD<V> p = TwoProd<V>(a.hi, b);
+    return QuickTwoSum<V>(p.hi, V::Add(p.lo, V::Mul(a.lo, b)));
+}
+
+// Doubling is exact
+template<class V>
+inline DD<V> Twice(const DD<V>& a)
+{
+    return { V::Add(a.hi, a.hi), V::Add(a.lo, a.lo) };
+}
+
+// The sign of the whole number is the sign of hi
+template<class V>
+inline DD<V> Abs(const DD<V>& a)
+{
+    auto negative = V::CmpLt(a.hi, V::Zero());
+    return { V::Blend(negative, V::Sub(V::Zero(), a.hi), a.hi), V::Blend(negative, V::Sub(V::Zero(), a.lo), a.lo) };
+}
+
+template<class V>
+inline DD<V> Blend(typename V::Reg mask, const DD<V>& a, const DD<V>& b)
+{
+    return { V::Blend(mask, a.hi, b.hi), V::Blend(mask, a.lo, b.lo) };
+}
+
+// State of one orbit per lane, same layout as Orbit
+// r is |z|^2 of the previous z, only the hi parts are needed for the escape test
+template<class V>
+struct OrbitDD
+{
+    DD<V> x, y;
+    DD<V> xprev, yprev;
+    typename V::Reg r;
+};
+
+// A list of pixels for the double-double kernels to compute
+struct StreamJobDD
+{
+    const int* pixels;  // Pixel indices (y * width + x)
+    int numPixels;
+    int width;
+
+    // Complex plane position of pixel 0 (hi + lo) and the size of a pixel
+    double xMinHi, xMinLo;
+    double yMinHi, yMinLo;
+    double dx, dy;
+
+    int* iterations;    // Output, one per entry in pixels
+};
+
+// Streaming escape time loop in double-double, the same lane refill scheme as StreamKernel
+// formula.Step<V>(orbit, cx, cy) does one iteration, an optional Formula::Interior(cx, cy) is
+// given the rounded point
+template<class V, class Formula>
+int StreamKernelDD(const StreamJobDD& job, const Formula& formula, int maxIterations, float rMax, double periodTolerance)
+{
+    using Reg = typename V::Reg;
+    using Scalar = typename V::Scalar;
+    constexpr int L = V::Lanes;
+
+    if (job.numPixels <= 0) return 0;
+
+    // Per lane bookkeeping, only touched when a lane is refilled
+    // A double-double takes two slots, hi at [lane] and lo at [L + lane]
+    alignas(64) Scalar cxLane[2 * L], cyLane[2 * L], nLane[L], rLane[L], validLane[L];
+    alignas(64) Scalar xLane[2 * L], yLane[2 * L], xprevLane[2 * L], yprevLane[2 * L];
+    alignas(64) Scalar xRefLane[2 * L], yRefLane[2 * L], checkLane[L];
+    alignas(64) Scalar xprevRefLane[2 * L], yprevRefLane[2 * L]; // Second order formulas only
+    int slot[L];
+    int retired = 0;
+
+    const Scalar allSet = [] { Scalar s; memset(&s, 0xFF, sizeof(s)); return s; }();
+    int next = 0;
+
+    auto pixelPosition = [&](double minHi, double minLo, double offset)
+    {
+        // min + offset, keeping the bits of the offset that fall off the end of min.hi
+        DD<ScalarD> s = TwoSum<ScalarD>(minHi, offset);
+        return QuickTwoSum<ScalarD>(s.hi, s.lo + minLo);
+    };
+
+    auto refill = [&](int lane)
+    {
+        for (Scalar* p : { xLane, yLane, xprevLane, yprevLane, xRefLane, yRefLane, xprevRefLane, yprevRefLane })
+        {
+            p[lane] = p[L + lane] = 0;
+        }
+        rLane[lane] = nLane[lane] = 0;
+        checkLane[lane] = 1;
+
+        if constexpr (requires { Formula::Interior(0.0, 0.0); })
+        {
+            while (next < job.numPixels)
+            {
+                int pixel = job.pixels[next];
+                double cx = pixelPosition(job.xMinHi, job.xMinLo, (pixel % job.width) * job.dx).hi;
+                double cy = pixelPosition(job.yMinHi, job.yMinLo, (pixel / job.width) * job.dy).hi;
+                if (!Formula::Interior(cx, cy)) break;
+
+                job.iterations[next++] = maxIterations;
+            }
+        }
+
+        if (next < job.numPixels)
+        {
+            int pixel = job.pixels[next];
+            DD<ScalarD> cx = pixelPosition(job.xMinHi, job.xMinLo, (pixel % job.width) * job.dx);
+            DD<ScalarD> cy = pixelPosition(job.yMinHi, job.yMinLo, (pixel / job.width) * job.dy);
+            cxLane[lane] = cx.hi; cxLane[L + lane] = cx.lo;
+            cyLane[lane] = cy.hi; cyLane[L + lane] = cy.lo;
+            validLane[lane] = allSet;
+            slot[lane] = next++;
+        }
+        else
+        {
+            cxLane[lane] = cxLane[L + lane] = cyLane[lane] = cyLane[L + lane] = 0;
+            validLane[lane] = 0;
+            slot[lane] = -1;
+        }
+    };
+
+    auto load = [](const Scalar* p) { return DD<V>{ V::Load(p), V::Load(p + L) }; };
+    auto store = [](Scalar* p, const DD<V>& a) { V::Store(p, a.hi); V::Store(p + L, a.lo); };
+
+    for (int lane = 0; lane < L; ++lane)
+    {
+        refill(lane);
+    }
+
+    if (slot[0] < 0) return 0;
+
+    const Reg vrMax = V::Set1(static_cast<Scalar>(rMax));
+    const Reg vMaxIter = V::Set1(static_cast<Scalar>(maxIterations));
+    const Reg one = V::Set1(1);
+    const Reg tolerance = V::Set1(static_cast<Scalar>(periodTolerance));
+
+    OrbitDD<V> z;
+    z.x = z.y = z.xprev = z.yprev = load(xLane);
+    z.r = V::Zero();
+    DD<V> cx = load(cxLane), cy = load(cyLane);
+    DD<V> xRef = z.x, yRef = z.x;
+    DD<V> xprevRef = z.x, yprevRef = z.x;
+    Reg n = V::Zero();
+    Reg valid = V::Load(validLane);
+    Reg check = V::Load(checkLane);
+
+    while (true)
+    {
+        Reg active = V::And(V::And(V::CmpLt(z.r, vrMax), V::CmpLt(n, vMaxIter)), valid);
+        int done = V::MoveMask(V::AndNot(active, valid));
+
+        if (done)
+        {
+            V::Store(nLane, n);
+            V::Store(rLane, z.r);
+            V::Store(checkLane, check);
+            store(xLane, z.x); store(yLane, z.y);
+            store(xprevLane, z.xprev); store(yprevLane, z.yprev);
+            store(xRefLane, xRef); store(yRefLane, yRef);
+            if constexpr (IsSecondOrder<Formula>)
+            {
+                store(xprevRefLane, xprevRef); store(yprevRefLane, yprevRef);
+            }
+
+            for (int lane = 0; lane < L; ++lane)
+            {
+                if (done & (1 << lane))
+                {
+                    job.iterations[slot[lane]] = static_cast<int>(nLane[lane]);
+                    refill(lane);
+                }
+            }
+
+            n = V::Load(nLane);
+            z.r = V::Load(rLane);
+            check = V::Load(checkLane);
+            z.x = load(xLane); z.y = load(yLane);
+            z.xprev = load(xprevLane); z.yprev = load(yprevLane);
+            xRef = load(xRefLane); yRef = load(yRefLane);
+            if constexpr (IsSecondOrder<Formula>)
+            {
+                xprevRef = load(xprevRefLane); yprevRef = load(yprevRefLane);
+            }
+            cx = load(cxLane); cy = load(cyLane);
+            valid = V::Load(validLane);
+
+            if (!V::MoveMask(valid)) break;
+            active = valid;
+        }
+
+        formula.template Step<V>(z, cx, cy);
+        n = V::Add(n, V::And(active, one));
+
+        // Brent cycle detection on StreamKernel's schedule, the tolerance is below what hi alone can
+        // resolve so the differences take in the lo parts too
+        auto near = [&](const DD<V>& a, const DD<V>& ref)
+        {
+            return V::CmpLe(V::Abs(V::Add(V::Sub(a.hi, ref.hi), V::Sub(a.lo, ref.lo))), tolerance);
+        };
+        Reg hit = V::And(active, V::And(near(z.x, xRef), near(z.y, yRef)));
+        if constexpr (IsSecondOrder<Formula>)
+        {
+            hit = V::And(hit, V::And(near(z.xprev, xprevRef), near(z.yprev, yprevRef)));
+        }
+        if (int hitLanes = V::MoveMask(hit))
+        {
+            retired += std::popcount(static_cast<unsigned>(hitLanes));
+            n = V::Blend(hit, vMaxIter, n);
+        }
+
+        Reg move = V::CmpEq(n, check);
+        xRef = Blend<V>(move, z.x, xRef);
+        yRef = Blend<V>(move, z.y, yRef);
+        if constexpr (IsSecondOrder<Formula>)
+        {
+            xprevRef = Blend<V>(move, z.xprev, xprevRef);
+            yprevRef = Blend<V>(move, z.yprev, yprevRef);
+        }
+        check = V::Blend(move, V::Add(V::Add(check, check), one), check);
+    }
+
+    return retired;
+}
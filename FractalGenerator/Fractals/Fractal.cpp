@@ -12,184 +12,622 @@
 #include "../App.h"
 #include "fractal.h"
 
-void Fractal::UseCPP(Colour* pixelBuffer, int yStart, int yEnd, bool useFloat)
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+thread_local Fractal::KernelCounters Fractal::s_counters{};
+
+void Fractal::UseKernels(int* iterationBuffer, int xStart, int xEnd, int yStart, int yEnd, bool useFloat, bool stream)
 {
-    // Variables for updating the x and y values
-    // Essentially mapping a complex plane point to a pixel
-    double dx = (m_xMax - m_xMin) / static_cast<double>(m_app->m_widthW);
-    double dy = (m_yMax - m_yMin) / static_cast<double>(m_app->m_heightW);
+    // A tile is at most m_tileSize x m_tileSize pixels
+    int pixels[m_tileSize * m_tileSize];
+    int iterations[m_tileSize * m_tileSize];
 
-    double yval = m_yMin + yStart * dy;
+    StreamJob job{};
+    job.pixels = pixels;
+    job.width = m_app->m_widthW;
+    job.xMin = m_xMin;
+    job.yMin = m_yMin;
+    job.dx = (m_xMax - m_xMin) / static_cast<double>(m_app->m_widthW);
+    job.dy = (m_yMax - m_yMin) / static_cast<double>(m_app->m_heightW);
+    job.iterations = iterations;
+
+    // The whole tile goes in as one list of pixels, row by row
+    // Less the ones CopyLastFrame already filled in, and the ones for another pass
     for (int y = yStart; y < yEnd; ++y)
     {
-        double xval = m_xMin;
-        for (int x = 0; x < m_app->m_widthW; ++x)
+        const bool rowCopied = m_reuseFrame && m_sourceRows[y] >= 0;
+
+        for (int x = xStart; x < xEnd; ++x)
         {
-            int n;
-            if (useFloat)
+            if ((!rowCopied || m_sourceColumns[x] < 0) && InPass(x, y))
             {
-                n = GetCPPIterF(static_cast<float>(xval), static_cast<float>(yval));
+                pixels[job.numPixels++] = y * m_app->m_widthW + x;
             }
-            else
+        }
+    }
+
+    if (job.numPixels == 0)
+    {
+        return;
+    }
+
+    IterateJob(job, useFloat, m_app->GetLanguage(), stream);
+
+    for (int i = 0; i < job.numPixels; ++i)
+    {
+        iterationBuffer[pixels[i]] = iterations[i];
+    }
+}
+
+void Fractal::UseBlocks(int* iterationBuffer, int xStart, int xEnd, int yStart, int yEnd, bool useFloat)
+{
+    UseKernels(iterationBuffer, xStart, xEnd, yStart, yEnd, useFloat, false);
+}
+
+void Fractal::UseStream(int* iterationBuffer, int xStart, int xEnd, int yStart, int yEnd, bool useFloat)
+{
+    UseKernels(iterationBuffer, xStart, xEnd, yStart, yEnd, useFloat, true);
+}
+
+void Fractal::DoubleDoublePixels(int* iterationBuffer, const int* pixels, int numPixels)
+{
+    int iterations[m_tileSize * m_tileSize];
+
+    // The corner of the view comes from the high precision centre, doubles would have rounded it
+    StreamJobDD job{};
+    job.pixels = pixels;
+    job.numPixels = numPixels;
+    job.width = m_app->m_widthW;
+    (m_centreX - FixedPoint(m_xRange / 2)).ToDoubleDouble(job.xMinHi, job.xMinLo);
+    (m_centreY - FixedPoint(m_yRange / 2)).ToDoubleDouble(job.yMinHi, job.yMinLo);
+    job.dx = m_xRange / static_cast<double>(m_app->m_widthW);
+    job.dy = m_yRange / static_cast<double>(m_app->m_heightW);
+    job.iterations = iterations;
+
+    IterateJobDD(job, m_app->GetLanguage());
+
+    for (int i = 0; i < numPixels; ++i)
+    {
+        iterationBuffer[pixels[i]] = iterations[i];
+    }
+}
+
+void Fractal::UseDoubleDouble(int* iterationBuffer, int xStart, int xEnd, int yStart, int yEnd, bool useFloat)
+{
+    int pixels[m_tileSize * m_tileSize];
+    int numPixels = 0;
+
+    for (int y = yStart; y < yEnd; ++y)
+    {
+        for (int x = xStart; x < xEnd; ++x)
+        {
+            if (InPass(x, y))
             {
-                n = GetCPPIterD(xval, yval);
+                pixels[numPixels++] = y * m_app->m_widthW + x;
             }
-
-            MapColour(&pixelBuffer[y * m_app->m_widthW + x], static_cast<uint8_t>(n));
-            xval += dx;
         }
-        yval += dy;
+    }
+
+    if (numPixels > 0)
+    {
+        DoubleDoublePixels(iterationBuffer, pixels, numPixels);
     }
 }
 
-void Fractal::UseSSE(Colour* pixelBuffer, int yStart, int yEnd, bool useFloat)
+void Fractal::ComputeRect(SubdivideTile& tile, int x0, int x1, int y0, int y1, bool borderOnly)
 {
-    if (useFloat)
+    int pixels[m_tileSize * m_tileSize];
+    int slots[m_tileSize * m_tileSize]; // Where each pixel goes in the tile
+    int iterations[m_tileSize * m_tileSize];
+
+    StreamJob job{};
+    job.pixels = pixels;
+    job.width = m_app->m_widthW;
+    job.xMin = m_xMin;
+    job.yMin = m_yMin;
+    job.dx = (m_xMax - m_xMin) / static_cast<double>(m_app->m_widthW);
+    job.dy = (m_yMax - m_yMin) / static_cast<double>(m_app->m_heightW);
+    job.iterations = iterations;
+
+    // Gather the pixels nobody has computed yet, rectangles that share an edge only compute it once
+    for (int y = y0; y <= y1; ++y)
     {
-        float dx = static_cast<float>((m_xMax - m_xMin) / m_app->m_widthW);
-        float dy = static_cast<float>((m_yMax - m_yMin) / m_app->m_heightW);
-        const __m128 xShift_coeffs = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
-        __m128 yval = _mm_add_ps(_mm_set1_ps(static_cast<float>(m_yMin)), _mm_mul_ps(_mm_set1_ps(static_cast<float>(yStart)), _mm_set1_ps(dy))); // Setting initial yval to startin range of y
-        __m128 xShift = _mm_mul_ps(_mm_set1_ps(dx), xShift_coeffs); // Amount to shift x for each number we will be processing
-        __m128 dxSSE = _mm_set1_ps(m_sseVectSizeF * dx); // Amount to change multiplied by the number of floats calculated in parallel
-        __m128 dySSE = _mm_set1_ps(dy); // The change for y each time will be the default
+        // Between the top and bottom rows the border is just the first and last column
+        int step = borderOnly && y != y0 && y != y1 && x1 > x0 ? x1 - x0 : 1;
 
-        for (int y = yStart; y < yEnd; ++y)
+        for (int x = x0; x <= x1; x += step)
         {
-            __m128 xval = _mm_add_ps(_mm_set1_ps(static_cast<float>(m_xMin)), xShift); // Initial x values for first floats
-
-            for (int x = 0; x < m_app->m_widthW; x += m_sseVectSizeF) // Increase by the amount of floats being processed each time
+            int slot = y * tile.width + x;
+            if (tile.iterations[slot] < 0)
             {
-                __m128i iter = GetSSEIterF(xval, yval); // Calculate amount of iterations for the floats
+                slots[job.numPixels] = slot;
+                pixels[job.numPixels++] = (tile.yStart + y) * m_app->m_widthW + tile.xStart + x;
+            }
+        }
+    }
 
-                int* n_int = (int*)(&iter); // Pointer to the number of iterations
-                int pixel_i = y * m_app->m_widthW + x; // Current pixel index
+    IterateJob(job, tile.useFloat, tile.language, true);
 
-                // Colour the pixels that are loaded
-                for (int i = 0; i < m_sseVectSizeF; ++i, ++pixel_i)
+    for (int i = 0; i < job.numPixels; ++i)
+    {
+        tile.iterations[slots[i]] = iterations[i];
+    }
+}
+
+void Fractal::SubdivideRect(SubdivideTile& tile, int x0, int x1, int y0, int y1)
+{
+    ComputeRect(tile, x0, x1, y0, y1, true);
+
+    // Too thin to have an inside, the border was all of it
+    if (x1 - x0 < 2 || y1 - y0 < 2)
+    {
+        return;
+    }
+
+    const int* iterations = tile.iterations;
+    const int n = iterations[y0 * tile.width + x0];
+    bool uniform = true;
+
+    for (int x = x0; x <= x1 && uniform; ++x)
+    {
+        uniform = iterations[y0 * tile.width + x] == n && iterations[y1 * tile.width + x] == n;
+    }
+
+    for (int y = y0 + 1; y < y1 && uniform; ++y)
+    {
+        uniform = iterations[y * tile.width + x0] == n && iterations[y * tile.width + x1] == n;
+    }
+
+    // The whole border escaped at the same iteration (or never escaped), so the inside has too
+    if (uniform)
+    {
+        for (int y = y0 + 1; y < y1; ++y)
+        {
+            for (int x = x0 + 1; x < x1; ++x)
+            {
+                int& slot = tile.iterations[y * tile.width + x];
+                if (slot < 0)
                 {
-                    uint8_t n = (uint8_t)(n_int[i]); // Changing the pointer to unsigned int
-                    MapColour(&pixelBuffer[pixel_i], n);
+                    slot = n;
+                    ++s_counters.subdivideFills;
                 }
-
-                xval = _mm_add_ps(xval, dxSSE); // Updating the x values
             }
-
-            yval = _mm_add_ps(yval, dySSE); // Updating the y value
         }
+        return;
     }
-    else
+
+    // Small enough that splitting again would cost more than it saves
+    if (x1 - x0 <= m_subdivideMinSize || y1 - y0 <= m_subdivideMinSize)
     {
-        double dx = (m_xMax - m_xMin) / static_cast<double>(m_app->m_widthW);
-        double dy = (m_yMax - m_yMin) / static_cast<double>(m_app->m_heightW);
-        __m128d xShift_coeffs = _mm_set_pd(1.0, 0.0); // 2 doubles
-        __m128d yval = _mm_add_pd(_mm_set1_pd(m_yMin), _mm_mul_pd(_mm_set1_pd(yStart), _mm_set1_pd(dy))); // Setting initial yval
-        __m128d xShift = _mm_mul_pd(_mm_set1_pd(dx), xShift_coeffs); // Amount to shift x for each pair of numbers
-        __m128d dxSSE = _mm_set1_pd(m_sseVectSizeD * dx); // Amount to change for 2 doubles at a time
-        __m128d dySSE = _mm_set1_pd(dy); // The change in y is the default value
+        ComputeRect(tile, x0 + 1, x1 - 1, y0 + 1, y1 - 1, false);
+        return;
+    }
 
-        for (int y = yStart; y < yEnd; ++y) {
-            __m128d xval = _mm_add_pd(_mm_set1_pd(m_xMin), xShift); // Initial x values for the first 2 doubles
+    // Split into four, neighbours share the middle row/column
+    int xm = (x0 + x1) / 2;
+    int ym = (y0 + y1) / 2;
+    SubdivideRect(tile, x0, xm, y0, ym);
+    SubdivideRect(tile, xm, x1, y0, ym);
+    SubdivideRect(tile, x0, xm, ym, y1);
+    SubdivideRect(tile, xm, x1, ym, y1);
+}
 
-            for (int x = 0; x < m_app->m_widthW; x += m_sseVectSizeD) { // Increase by the number of doubles being processed per iteration
-                __m128i iter = GetSSEIterD(xval, yval); // Calculate iterations for the doubles
+void Fractal::UseSubdivide(int* iterationBuffer, int xStart, int xEnd, int yStart, int yEnd, bool useFloat)
+{
+    SubdivideTile tile;
+    tile.xStart = xStart;
+    tile.yStart = yStart;
+    tile.width = xEnd - xStart;
+    tile.height = yEnd - yStart;
+    tile.useFloat = useFloat;
+    tile.language = m_app->GetLanguage();
+    std::fill_n(tile.iterations, tile.width * tile.height, -1);
 
-                int* n_int = (int*)(&iter); // Pointer to the number of iterations
-                int pixel_i = y * m_app->m_widthW + x; // Current pixel index
+    SubdivideRect(tile, 0, tile.width - 1, 0, tile.height - 1);
 
-                // Colour the pixels for the doubles being calculated in parallel
-                for (int i = 0; i < m_sseVectSizeD; ++i, ++pixel_i) {
-                    uint8_t n = (uint8_t)(n_int[i]); // Changing the pointer to unsigned int
-                    MapColour(&pixelBuffer[pixel_i], n);
-                }
+    for (int y = 0; y < tile.height; ++y)
+    {
+        std::copy_n(&tile.iterations[y * tile.width], tile.width, &iterationBuffer[(yStart + y) * m_app->m_widthW + xStart]);
+    }
+}
 
-                xval = _mm_add_pd(xval, dxSSE); // Update the x values
-            }
+int Fractal::GetDeepZoomPower() const
+{
+    return 0;
+}
+
+void Fractal::ComputeReference(const FixedPoint& cx, const FixedPoint& cy)
+{
+    const int power = GetDeepZoomPower();
+
+    m_reference.power = power;
+    m_reference.x.clear();
+    m_reference.y.clear();
+    m_reference.skip = 0;
+    m_reference.seriesX.clear();
+    m_reference.seriesY.clear();
+
+    // Z_0 = 0, Z_n+1 = Z_n^d + c, kept going until it escapes (the escaped point is kept too)
+    FixedPoint zx, zy;
+    for (int n = 0; n <= m_maxIterations; ++n)
+    {
+        double x = zx.ToDouble(), y = zy.ToDouble();
+        m_reference.x.push_back(x);
+        m_reference.y.push_back(y);
+
+        if (x * x + y * y >= m_rMax)
+        {
+            break;
+        }
+
+        FixedPoint px = zx, py = zy;
+        for (int k = 1; k < power; ++k)
+        {
+            FixedPoint tx = px * zx - py * zy;
+            py = px * zy + py * zx;
+            px = tx;
+        }
+
+        zx = px + cx;
+        zy = py + cy;
+    }
+
+    const int length = static_cast<int>(m_reference.x.size());
+    m_reference.length = length;
+    m_reference.coefX.assign((power - 1) * length, 0.0);
+    m_reference.coefY.assign((power - 1) * length, 0.0);
+
+    // a_k = C(d, k) Z^(d-k), plain doubles are plenty for these
+    for (int n = 0; n < length; ++n)
+    {
+        double zpx[16] = { 1.0 }, zpy[16] = { 0.0 }; // Z^0 ... Z^(d-1)
+        for (int j = 1; j < power; ++j)
+        {
+            zpx[j] = zpx[j - 1] * m_reference.x[n] - zpy[j - 1] * m_reference.y[n];
+            zpy[j] = zpx[j - 1] * m_reference.y[n] + zpy[j - 1] * m_reference.x[n];
+        }
 
-            yval = _mm_add_pd(yval, dySSE); // Update the y value
+        double binomial = 1.0;
+        for (int k = 1; k < power; ++k)
+        {
+            binomial = binomial * (power - k + 1) / k;
+            m_reference.coefX[(k - 1) * length + n] = binomial * zpx[power - k];
+            m_reference.coefY[(k - 1) * length + n] = binomial * zpy[power - k];
         }
     }
 }
 
-void Fractal::UseAVX(Colour* pixelBuffer, int yStart, int yEnd, bool useFloat)
+void Fractal::ComputeSeries(double radius)
 {
-    if (useFloat)
-    {
-        float dx = static_cast<float>((m_xMax - m_xMin) / m_app->m_widthW);
-        float dy = static_cast<float>((m_yMax - m_yMin) / m_app->m_heightW);
-        const __m256 xShift_coeffs = _mm256_set_ps(7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f); // Shifting coefficients values
-        __m256 yval = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(m_yMin)), _mm256_mul_ps(_mm256_set1_ps(static_cast<float>(yStart)), _mm256_set1_ps(dy))); // Setting initial yval to startin range of y
-        __m256 xShift = _mm256_mul_ps(_mm256_set1_ps(dx), xShift_coeffs); // Amount to shift x for each number we will be processing
-        __m256 dxSSE = _mm256_set1_ps(m_avxVectSizeF * dx); // Amount to change multiplied by the number of floats calculated in parallel
-        __m256 dySSE = _mm256_set1_ps(dy); // The change for y each time will be the default
+    const int power = m_reference.power, length = m_reference.length;
+    const int T = m_seriesTerms;
+    const double escape = std::sqrt(static_cast<double>(m_rMax));
 
-        for (int y = yStart; y < yEnd; ++y)
+    // Coefficients of dz_n as a series in u = dc / radius, b[j] is the u^j term (b[0] is unused)
+    double bx[T + 1] = {}, by[T + 1] = {};
+
+    // Probe pixels on the corners and edges of the view, iterated exactly to check the series against
+    const double hx = m_xRange / 2, hy = m_yRange / 2;
+    const double probeDcx[] = { -hx, hx, -hx, hx, -hx, hx, 0, 0 };
+    const double probeDcy[] = { -hy, -hy, hy, hy, 0, 0, -hy, hy };
+    const int numProbes = sizeof(probeDcx) / sizeof(probeDcx[0]);
+    double probeX[numProbes] = {}, probeY[numProbes] = {};
+
+    int skip = 0;
+    double bestX[T] = {}, bestY[T] = {};
+
+    for (int n = 0; n < length - 1 && n < m_maxIterations; ++n)
+    {
+        if (n > 0)
         {
-            __m256 xval = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(m_xMin)), xShift); // Initial x values for first floats
+            // Bound on |dz| over the view (|u| <= 1)
+            double size = 0;
+            for (int j = 1; j <= T; ++j)
+            {
+                size += std::hypot(bx[j], by[j]);
+            }
+
+            // The last term has to stay negligible or the ones we dropped won't be
+            bool valid = std::hypot(bx[T], by[T]) <= m_seriesTolerance * std::hypot(bx[1], by[1]);
 
-            for (int x = 0; x < m_app->m_widthW; x += m_avxVectSizeF) // Increase by the amount of floats being processed each time
+            // No pixel can be near a rebase or an escape yet
+            const double zr = std::hypot(m_reference.x[n], m_reference.y[n]);
+            valid = valid && 2 * size < zr && zr + size < escape;
+
+            for (int i = 0; valid && i < numProbes; ++i)
+            {
+                // Same sum as SeriesStart
+                const double ux = probeDcx[i] / radius, uy = probeDcy[i] / radius;
+                double sx = 0, sy = 0;
+                for (int j = T; j >= 1; --j)
+                {
+                    double tx = (sx + bx[j]) * ux - (sy + by[j]) * uy;
+                    sy = (sx + bx[j]) * uy + (sy + by[j]) * ux;
+                    sx = tx;
+                }
+
+                valid = std::hypot(sx - probeX[i], sy - probeY[i]) <= m_seriesTolerance * std::hypot(probeX[i], probeY[i]);
+            }
+
+            if (!valid)
             {
-                __m256i N = GetAVXIterF(xval, yval); // Calculate amount of iterations for the floats
+                break;
+            }
+
+            skip = n;
+            for (int j = 0; j < T; ++j)
+            {
+                bestX[j] = bx[j + 1];
+                bestY[j] = by[j + 1];
+            }
+        }
+
+        // dz_n+1 = sum a_k dz_n^k + dc, with the powers of the series truncated to T terms
+        double nx[T + 1] = {}, ny[T + 1] = {};
+        double px[T + 1], py[T + 1]; // dz_n^k
+        for (int j = 0; j <= T; ++j)
+        {
+            px[j] = bx[j];
+            py[j] = by[j];
+        }
 
-                int* N_int = (int*)(&N); // Pointer to the number of iterations
-                int pixel_i = y * m_app->m_widthW + x; // Current pixel index
+        for (int k = 1; k <= power; ++k)
+        {
+            if (k > 1)
+            {
+                // Terms of dz^k start at u^k
+                double qx[T + 1] = {}, qy[T + 1] = {};
+                for (int j = k; j <= T; ++j)
+                {
+                    for (int i = 1; i < j; ++i)
+                    {
+                        qx[j] += px[j - i] * bx[i] - py[j - i] * by[i];
+                        qy[j] += px[j - i] * by[i] + py[j - i] * bx[i];
+                    }
+                }
 
-                // Colour the pixels that are loaded
-                for (int i = 0; i < m_avxVectSizeF; ++i, ++pixel_i)
+                for (int j = 0; j <= T; ++j)
                 {
-                    uint8_t n = (uint8_t)(N_int[i]); // Changing the pointer to unsigned int
-                    MapColour(&pixelBuffer[pixel_i], n);
+                    px[j] = qx[j];
+                    py[j] = qy[j];
                 }
+            }
+
+            const double ax = k < power ? m_reference.coefX[(k - 1) * length + n] : 1.0;
+            const double ay = k < power ? m_reference.coefY[(k - 1) * length + n] : 0.0;
+            for (int j = k; j <= T; ++j)
+            {
+                nx[j] += ax * px[j] - ay * py[j];
+                ny[j] += ax * py[j] + ay * px[j];
+            }
+        }
+
+        nx[1] += radius;
+        for (int j = 0; j <= T; ++j)
+        {
+            bx[j] = nx[j];
+            by[j] = ny[j];
+        }
 
-                xval = _mm256_add_ps(xval, dxSSE); // Updating the x values
+        // The probes take the same step the perturbation kernels would
+        for (int i = 0; i < numProbes; ++i)
+        {
+            double qx = 1, qy = 0;
+            for (int k = power - 1; k >= 1; --k)
+            {
+                double tx = qx * probeX[i] - qy * probeY[i] + m_reference.coefX[(k - 1) * length + n];
+                qy = qx * probeY[i] + qy * probeX[i] + m_reference.coefY[(k - 1) * length + n];
+                qx = tx;
             }
 
-            yval = _mm256_add_ps(yval, dySSE); // Updating the y value
+            double tx = probeX[i] * qx - probeY[i] * qy + probeDcx[i];
+            probeY[i] = probeX[i] * qy + probeY[i] * qx + probeDcy[i];
+            probeX[i] = tx;
         }
     }
+
+    m_reference.skip = skip;
+    m_reference.seriesRadius = radius;
+    if (skip > 0)
+    {
+        m_reference.seriesX.assign(bestX, bestX + T);
+        m_reference.seriesY.assign(bestY, bestY + T);
+    }
     else
     {
-        double dx = (m_xMax - m_xMin) / static_cast<double>(m_app->m_widthW);
-        double dy = (m_yMax - m_yMin) / static_cast<double>(m_app->m_heightW);
-        const __m256d xShift_coeffs = _mm256_set_pd(3.0, 2.0, 1.0, 0.0); // Shifting coefficients values
-        __m256d yval = _mm256_add_pd(_mm256_set1_pd(m_yMin), _mm256_mul_pd(_mm256_set1_pd(yStart), _mm256_set1_pd(dy))); // Setting initial yval to startin range of y
-        __m256d xShift = _mm256_mul_pd(_mm256_set1_pd(dx), xShift_coeffs); // Amount to shift x for each number we will be processing
-        __m256d dxSSE = _mm256_set1_pd(m_avxVectSizeD * dx); // Amount to change multiplied by the number of floats calculated in parallel
-        __m256d dySSE = _mm256_set1_pd(dy); // The change for y each time will be the default
+        m_reference.seriesX.clear();
+        m_reference.seriesY.clear();
+    }
+}
 
-        for (int y = yStart; y < yEnd; ++y)
-        {
-            __m256d xval = _mm256_add_pd(_mm256_set1_pd(m_xMin), xShift); // Initial x values for first floats
+void Fractal::DeepZoomPixels(int* iterationBuffer, const int* pixels, int numPixels)
+{
+    int iterations[m_tileSize * m_tileSize];
 
-            for (int x = 0; x < m_app->m_widthW; x += m_avxVectSizeD) // Increase by the amount of floats being processed each time
+    // Offsets are from the reference, which is m_refOffset away from the view centre
+    PerturbJob job{};
+    job.pixels = pixels;
+    job.numPixels = numPixels;
+    job.width = m_app->m_widthW;
+    job.dx = m_xRange / static_cast<double>(m_app->m_widthW);
+    job.dy = m_yRange / static_cast<double>(m_app->m_heightW);
+    job.dcx = -m_xRange / 2 - m_refOffsetX;
+    job.dcy = -m_yRange / 2 - m_refOffsetY;
+    job.reference = &m_reference;
+    job.iterations = iterations;
+
+    switch (m_app->GetLanguage())
+    {
+    case ID_LANGUAGE_SSE:
+    case ID_LANGUAGE_SSE_MT:
+    {
+        PerturbKernel<SseD>(job, m_maxIterations, m_rMax);
+        break;
+    }
+    case ID_LANGUAGE_AVX:
+    case ID_LANGUAGE_AVX_MT:
+    case ID_LANGUAGE_AVX512:
+    case ID_LANGUAGE_AVX512_MT:
+    {
+        PerturbKernel<AvxD>(job, m_maxIterations, m_rMax);
+        break;
+    }
+    default:
+    {
+        PerturbScalar(job, m_maxIterations, m_rMax);
+        break;
+    }
+    } // Switch
+
+    // Glitched pixels come back as -1 and are left for the next reference
+    for (int i = 0; i < numPixels; ++i)
+    {
+        iterationBuffer[pixels[i]] = iterations[i];
+    }
+}
+
+void Fractal::UseDeepZoom(int* iterationBuffer, int xStart, int xEnd, int yStart, int yEnd, bool useFloat)
+{
+    int pixels[m_tileSize * m_tileSize];
+    int numPixels = 0;
+
+    for (int y = yStart; y < yEnd; ++y)
+    {
+        for (int x = xStart; x < xEnd; ++x)
+        {
+            if (InPass(x, y))
             {
-                __m256i N = GetAVXIterD(xval, yval); // Calculate amount of iterations for the floats
+                pixels[numPixels++] = y * m_app->m_widthW + x;
+            }
+        }
+    }
 
-                int* N_int = (int*)(&N); // Pointer to the number of iterations
-                int pixel_i = y * m_app->m_widthW + x; // Current pixel index
+    if (numPixels > 0)
+    {
+        DeepZoomPixels(iterationBuffer, pixels, numPixels);
+    }
+}
 
-                // Colour the pixels that are loaded
-                for (int i = 0; i < m_avxVectSizeD; ++i, ++pixel_i)
+void Fractal::RenderPixels(int* iterationBuffer, const std::vector<int>& pixels, PixelKernel kernel, int numWorkers)
+{
+    const int numPixels = static_cast<int>(pixels.size());
+    const int chunk = m_tileSize * m_tileSize;
+    auto run = [&, kernel](int start)
+    {
+        // A newer view came in, the rest of this frame is never going to be shown
+        if (m_app->IsRenderStale())
+        {
+            return;
+        }
+
+        (this->*kernel)(iterationBuffer, pixels.data() + start, numPixels - start < chunk ? numPixels - start : chunk);
+    };
+
+    if (numWorkers > 0)
+    {
+        TaskGroup tasks(m_app->GetThreadPool());
+        for (int start = 0; start < numPixels; start += chunk)
+        {
+            tasks.Run(std::bind(run, start));
+        }
+        tasks.Wait();
+    }
+    else
+    {
+        for (int start = 0; start < numPixels; start += chunk)
+        {
+            run(start);
+        }
+    }
+}
+
+void Fractal::PrepareDeepZoom()
+{
+    // First reference at the centre of the view
+    m_refOffsetX = m_refOffsetY = 0;
+    ComputeReference(m_centreX, m_centreY);
+    m_referencesUsed = 1;
+
+    // Every pixel is within half a diagonal of it, so they can all start where the series runs out
+    ComputeSeries(std::hypot(m_xRange / 2, m_yRange / 2));
+    m_seriesSkip = m_reference.skip;
+}
+
+void Fractal::RenderDeepZoom(int* iterationBuffer, int numWorkers)
+{
+    const int width = m_app->m_widthW, height = m_app->m_heightW;
+    const double dx = m_xRange / static_cast<double>(width);
+    const double dy = m_yRange / static_cast<double>(height);
+
+    RenderTiles(iterationBuffer, &Fractal::UseDeepZoom, false, numWorkers);
+
+    // Every pass gets the same number of references, the centre one included
+    int passReferences = 1;
+    bool centreAside = false;
+
+    std::vector<int> glitched;
+    while (true)
+    {
+        // Only this pass's pixels, the coarser ones were settled by their own pass
+        glitched.clear();
+        for (int y = 0; y < height; y += m_passStep)
+        {
+            for (int x = 0; x < width; x += m_passStep)
+            {
+                if (InPass(x, y) && iterationBuffer[y * width + x] < 0)
                 {
-                    uint8_t n = (uint8_t)(N_int[i]); // Changing the pointer to unsigned int
-                    MapColour(&pixelBuffer[pixel_i], n);
+                    glitched.push_back(y * width + x);
                 }
-
-                xval = _mm256_add_pd(xval, dxSSE); // Updating the x values
             }
+        }
 
-            yval = _mm256_add_pd(yval, dySSE); // Updating the y value
+        if (glitched.empty() || passReferences == m_maxReferences || m_app->IsRenderStale())
+        {
+            break;
+        }
+
+        // The next pass starts from the centre again
+        if (!centreAside)
+        {
+            std::swap(m_reference, m_centreReference);
+            centreAside = true;
         }
+
+        // New reference on one of the glitched pixels, they're usually in blobs around it
+        int pixel = glitched[glitched.size() / 2];
+        m_refOffsetX = (pixel % width) * dx - m_xRange / 2;
+        m_refOffsetY = (pixel / width) * dy - m_yRange / 2;
+        ComputeReference(m_centreX + FixedPoint(m_refOffsetX), m_centreY + FixedPoint(m_refOffsetY));
+        ++passReferences;
+        ++m_referencesUsed;
+
+        // Redo just the glitched pixels
+        RenderPixels(iterationBuffer, glitched, &Fractal::DeepZoomPixels, numWorkers);
+    }
+
+    if (centreAside)
+    {
+        std::swap(m_reference, m_centreReference);
+        m_refOffsetX = m_refOffsetY = 0;
+    }
+
+    if (m_app->IsRenderStale())
+    {
+        return;
     }
+
+    // Out of references, these get whatever double-doubles make of them
+    m_glitchedPixels += static_cast<int>(glitched.size());
+    RenderPixels(iterationBuffer, glitched, &Fractal::DoubleDoublePixels, numWorkers);
 }
 
-void Fractal::MapColour(Colour* pixelBuffer, uint8_t n)
+void Fractal::MapColour(Colour* pixelBuffer, int n, UINT gradient) const
 {
     // Color mapping for points outside of the set
     // The gradient depends on the menu option
 
-    UINT gradient = m_app->GetGradient();
-
     switch (gradient)
     {
     case ID_GRADIENT_1:
@@ -269,180 +707,428 @@ void Fractal::MapColour(Colour* pixelBuffer, uint8_t n)
     } // Switch
 }
 
-void Fractal::Render(Colour* pixelBuffer)
+void Fractal::RenderTiles(int* iterationBuffer, TileKernel kernel, bool useFloat, int numWorkers)
+{
+    // The passes of a progressive render spread a tile over m_passStep times the area, so every tile
+    // still has up to m_tileSize x m_tileSize pixels to compute and the kernels get full jobs
+    const int tileSize = m_tileSize * m_passStep;
+    const int tilesX = (m_app->m_widthW + tileSize - 1) / tileSize;
+    const int tilesY = (m_app->m_heightW + tileSize - 1) / tileSize; // Round up so the last partial row/column is covered
+
+    // Tiles the last frame covered completely were filled in by CopyLastFrame, and aren't handed out
+    // (scrolling leaves only the band along the edges it exposed)
+    std::vector<int> tiles;
+    tiles.reserve(tilesX * tilesY);
+
+    for (int tile = 0; tile < tilesX * tilesY; ++tile)
+    {
+        int xStart = (tile % tilesX) * tileSize;
+        int yStart = (tile / tilesX) * tileSize;
+        int xEnd = xStart + tileSize < m_app->m_widthW ? xStart + tileSize : m_app->m_widthW;
+        int yEnd = yStart + tileSize < m_app->m_heightW ? yStart + tileSize : m_app->m_heightW;
+
+        bool copied = m_reuseFrame &&
+            std::all_of(m_sourceColumns.begin() + xStart, m_sourceColumns.begin() + xEnd, [](int u) { return u >= 0; }) &&
+            std::all_of(m_sourceRows.begin() + yStart, m_sourceRows.begin() + yEnd, [](int v) { return v >= 0; });
+
+        if (!copied)
+        {
+            tiles.push_back(tile);
+        }
+    }
+
+    const int numTiles = static_cast<int>(tiles.size());
+
+    // Timings and counters add up over every pass of a frame, Render clears them at the start
+    const size_t firstTick = m_tileTicks.size();
+    m_tileTicks.resize(firstTick + numTiles, 0);
+    m_workerTicks.resize(numWorkers > 0 ? numWorkers : 1, 0);
+    m_workerCounters.resize(m_workerTicks.size(), KernelCounters{});
+
+    // Workers grab the next tile off the counter until there are none left
+    // Expensive tiles (the set's interior) no longer hold up a whole strip
+    std::atomic<int> nextTile{ 0 };
+
+    auto worker = [&](int workerIndex)
+    {
+        LARGE_INTEGER start, end;
+        s_counters = {};
+
+        for (int next = nextTile++; next < numTiles; next = nextTile++)
+        {
+            // A newer view came in, the rest of this frame is never going to be shown
+            if (m_app->IsRenderStale())
+            {
+                break;
+            }
+
+            int tile = tiles[next];
+            int xStart = (tile % tilesX) * tileSize;
+            int yStart = (tile / tilesX) * tileSize;
+            int xEnd = xStart + tileSize < m_app->m_widthW ? xStart + tileSize : m_app->m_widthW;
+            int yEnd = yStart + tileSize < m_app->m_heightW ? yStart + tileSize : m_app->m_heightW;
+
+            QueryPerformanceCounter(&start);
+            (this->*kernel)(iterationBuffer, xStart, xEnd, yStart, yEnd, useFloat);
+            QueryPerformanceCounter(&end);
+
+            // Recording the cost of each tile to see the load imbalance
+            m_tileTicks[firstTick + next] = end.QuadPart - start.QuadPart;
+            m_workerTicks[workerIndex] += m_tileTicks[firstTick + next];
+
+            // Hand this thread's counters over to the worker
+            m_workerCounters[workerIndex].cardioidSkips += s_counters.cardioidSkips;
+            m_workerCounters[workerIndex].periodicSkips += s_counters.periodicSkips;
+            m_workerCounters[workerIndex].subdivideFills += s_counters.subdivideFills;
+            s_counters = {};
+        }
+    };
+
+    if (numWorkers > 0)
+    {
+        TaskGroup tasks(m_app->GetThreadPool());
+        for (int i = 0; i < numWorkers; ++i)
+        {
+            tasks.Run(std::bind(worker, i));
+        }
+
+        // Wait for all tiles to complete (this thread helps out while it waits)
+        tasks.Wait();
+    }
+    else
+    {
+        worker(0);
+    }
+}
+
+bool Fractal::Render(Colour* pixelBuffer)
 {
     // Dynamically changing from float to double when resolution gets low
-    bool useDouble = m_yMax - m_yMin < m_floatToDouble;
+    bool useFloat = !(m_yMax - m_yMin < m_floatToDouble);
+
+    // Cycle detection tolerance follows the same pixel spacing the kernels step by
+    double dx = (m_xMax - m_xMin) / static_cast<double>(m_app->m_widthW);
+    double dy = (m_yMax - m_yMin) / static_cast<double>(m_app->m_heightW);
+    m_periodTolerance = (dx < dy ? dx : dy) * m_periodToleranceScale;
 
     UINT language = m_app->GetLanguage();
 
-    switch (language)
+    // The kernels pick the language's register width themselves
+    // Streaming swaps in the lane refill versions
+    TileKernel kernel = m_app->GetStreaming() ? &Fractal::UseStream : &Fractal::UseBlocks;
+
+    // Rectangle subdivision picks the language's kernels itself
+    if (m_app->GetSubdivide())
     {
+        kernel = &Fractal::UseSubdivide;
+    }
+
     // Use multithreading
+    // Every pool worker takes part, the tile queue keeps them all busy
+    int numWorkers = 0;
+    switch (language)
+    {
     case ID_LANGUAGE_CPP_MT:
     case ID_LANGUAGE_SSE_MT:
     case ID_LANGUAGE_AVX_MT:
+    case ID_LANGUAGE_AVX512_MT:
     {
-        int numThreads;
-        int cores = std::thread::hardware_concurrency(); // Number of available CPU cores
-        if (ID_LANGUAGE_AVX_MT == language)
+        numWorkers = static_cast<int>(m_app->GetThreadPool().GetNumThreads());
+        break;
+    }
+    } // Switch
+
+    m_referencesUsed = 0;
+    m_glitchedPixels = 0;
+    m_seriesSkip = 0;
+
+    m_tileTicks.clear();
+    m_workerTicks.clear();
+    m_workerCounters.clear();
+
+    // Past what doubles can resolve, pixels iterate their offset from a high precision reference
+    // Short of deep enough for perturbation (or for fractals that can't use it) they iterate in double-double
+    bool deepZoom = GetDeepZoomPower() > 0 && m_yRange < m_doubleToPerturbation;
+    if (!deepZoom && m_yRange < m_doubleToDoubleDouble)
+    {
+        kernel = &Fractal::UseDoubleDouble;
+    }
+
+    // Only the plain kernels sample on a grid the next frame can line up with
+    bool plain = !deepZoom && (kernel == &Fractal::UseBlocks || kernel == &Fractal::UseStream);
+
+    // The last frame's counts are kept aside while this one is written
+    m_reuseFrame = plain && m_app->GetReuse() && MapLastFrame(dx, dy, useFloat);
+    if (m_reuseFrame)
+    {
+        std::swap(m_iterations, m_lastIterations);
+    }
+
+    // Every tile writes its iteration counts, the colours come after in one pass
+    m_iterations.resize(m_app->m_widthW * m_app->m_heightW);
+    m_reusedPixels = m_reuseFrame ? CopyLastFrame(m_iterations.data()) : 0;
+
+    // The deep zoom reference is shared by every pass
+    if (deepZoom)
+    {
+        PrepareDeepZoom();
+    }
+
+    // Progressive renders start on every m_progressiveStep'th pixel and halve the spacing every pass,
+    // painting each pass as blocks. Every pixel is still computed once by the same kernels, so the
+    // last pass leaves the same counts as a single pass would (bar deep zoom glitches, whose extra
+    // references are picked from each pass's own glitched pixels)
+    // Subdivision fills rectangles from their borders, which the coarse grids would change
+    const bool progressive = m_app->GetProgressive() && kernel != &Fractal::UseSubdivide;
+
+    m_coarserStep = 0;
+    for (m_passStep = progressive ? m_progressiveStep : 1; ; m_passStep /= 2)
+    {
+        if (deepZoom)
         {
-            // Hard coded value that actually speeds up AVX Multithreaded
-            // Using to many cores is uncessary and slows it down, 8 is perfect
-            numThreads = cores < 8 ? cores : 8;
+            RenderDeepZoom(m_iterations.data(), numWorkers);
         }
         else
         {
-            numThreads = cores;
+            RenderTiles(m_iterations.data(), kernel, useFloat, numWorkers);
         }
 
-        int stripHeight = m_app->m_heightW / numThreads;
-        std::vector<std::thread> threads;
+        if (m_passStep == 1 || m_app->IsRenderStale())
+        {
+            break;
+        }
 
-        // Assign a thread to each strip
-        for (int i = 0; i < numThreads; ++i) {
-            int yStart = i * stripHeight;
+        FillPass(m_iterations.data());
+        Recolour(pixelBuffer);
+        m_app->ShowPass();
 
-            if (useDouble)
-            {
-                switch (language)
-                {
-                case ID_LANGUAGE_CPP_MT:
-                {
-                    threads.emplace_back(std::bind(
-                        &Fractal::UseCPP,
-                        this,
-                        pixelBuffer,
-                        yStart,
-                        yStart + stripHeight,
-                        false));
-                    break;
-                }
-                case ID_LANGUAGE_SSE_MT:
-                {
-                    threads.emplace_back(std::bind(
-                        &Fractal::UseSSE,
-                        this,
-                        pixelBuffer,
-                        yStart,
-                        yStart + stripHeight,
-                        false));
-                    break;
-                }
-                case ID_LANGUAGE_AVX_MT:
-                {
-                    threads.emplace_back(std::bind(
-                        &Fractal::UseAVX,
-                        this,
-                        pixelBuffer,
-                        yStart,
-                        yStart + stripHeight,
-                        false));
-                    break;
-                }
-                } // Switch
-            }
-            else
-            {
-                switch (language)
-                {
-                case ID_LANGUAGE_CPP_MT:
-                {
-                    threads.emplace_back(std::bind(
-                        &Fractal::UseCPP,
-                        this,
-                        pixelBuffer,
-                        yStart,
-                        yStart + stripHeight,
-                        true));
-                    break;
-                }
-                case ID_LANGUAGE_SSE_MT:
-                {
-                    threads.emplace_back(std::bind(
-                        &Fractal::UseSSE,
-                        this,
-                        pixelBuffer,
-                        yStart,
-                        yStart + stripHeight,
-                        true));
-                    break;
-                }
-                case ID_LANGUAGE_AVX_MT:
-                {
-                    threads.emplace_back(std::bind(
-                        &Fractal::UseAVX,
-                        this,
-                        pixelBuffer,
-                        yStart,
-                        yStart + stripHeight,
-                        true));
-                    break;
-                }
-                } // Switch
-            }
-        }
+        m_coarserStep = m_passStep;
+    }
 
-        // Wait for all threads to complete
-        for (auto& t : threads) {
-            t.join();
-        }
+    m_passStep = 1;
+    m_coarserStep = 0;
+
+    m_reuseFrame = false;
+
+    // Given up for a newer view, m_iterations only holds part of this frame
+    if (m_app->IsRenderStale())
+    {
+        m_lastViewValid = false;
+        return false;
+    }
+
+    m_lastView = { m_xMin, m_yMin, dx, dy, m_app->m_widthW, m_app->m_heightW, useFloat };
+    m_lastViewValid = plain;
+
+    Recolour(pixelBuffer);
 
+    return true;
+}
+
+void Fractal::Recolour(Colour* pixelBuffer)
+{
+    BuildPalette(m_app->GetGradient());
+
+    const int numPixels = static_cast<int>(m_iterations.size());
+    const int* iterations = m_iterations.data();
+    const int* palette = reinterpret_cast<const int*>(m_palette.data()); // A Colour is one 32 bit load
+    int i = 0;
+
+    // A palette gather per register of counts, 8 or 16 Colours per store
+    // Counts are clamped (unsigned, so a stray -1 is too) to stay inside the table
+    switch (m_app->GetLanguage())
+    {
+    case ID_LANGUAGE_AVX512:
+    case ID_LANGUAGE_AVX512_MT:
+    {
+        const __m512i last = _mm512_set1_epi32(m_maxIterations);
+        for (; i + 16 <= numPixels; i += 16)
+        {
+            __m512i n = _mm512_min_epu32(_mm512_loadu_si512(iterations + i), last);
+            _mm512_storeu_si512(pixelBuffer + i, _mm512_i32gather_epi32(n, palette, 4));
+        }
         break;
     }
-    case ID_LANGUAGE_CPP:
-    case ID_LANGUAGE_SSE:
     case ID_LANGUAGE_AVX:
+    case ID_LANGUAGE_AVX_MT:
     {
-        if (useDouble)
+        const __m256i last = _mm256_set1_epi32(m_maxIterations);
+        for (; i + 8 <= numPixels; i += 8)
         {
-            switch (language)
-            {
-            case ID_LANGUAGE_CPP:
-            {
-                UseCPP(pixelBuffer, 0, m_app->m_heightW, false);
-                break;
-            }
-            case ID_LANGUAGE_SSE:
-            {
-                UseSSE(pixelBuffer, 0, m_app->m_heightW, false);
-                break;
-            }
-            case ID_LANGUAGE_AVX:
-            {
-                UseAVX(pixelBuffer, 0, m_app->m_heightW, false);
-                break;
-            }
-            } // Switch
+            __m256i n = _mm256_min_epu32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(iterations + i)), last);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixelBuffer + i), _mm256_i32gather_epi32(palette, n, 4));
         }
-        else
+        break;
+    }
+    } // Switch
+
+    // The tail, and every pixel for C++ and SSE (no gathers before AVX2)
+    for (; i < numPixels; ++i)
+    {
+        pixelBuffer[i] = m_palette[std::min(static_cast<unsigned>(iterations[i]), static_cast<unsigned>(m_maxIterations))];
+    }
+}
+
+void Fractal::BuildPalette(UINT gradient)
+{
+    if (gradient == m_paletteGradient && !m_palette.empty())
+    {
+        return;
+    }
+
+    m_palette.resize(m_maxIterations + 1);
+    for (int n = 0; n <= m_maxIterations; ++n)
+    {
+        MapColour(&m_palette[n], n, gradient);
+    }
+
+    m_paletteGradient = gradient;
+    m_gifIndices.clear();
+}
+
+void Fractal::BuildGifPalette()
+{
+    GifPalette& palette = m_gifColours.palette;
+    palette = {};
+    palette.bitDepth = 8;
+    m_gifIndices.resize(m_palette.size());
+
+    // Every colour of the gradient gets its own entry if they fit
+    std::unordered_map<uint32_t, int> entries;
+    for (size_t n = 0; n < m_palette.size() && entries.size() <= 256; ++n)
+    {
+        const Colour& colour = m_palette[n];
+        entries.emplace((colour.r << 16) | (colour.g << 8) | colour.b, -1);
+    }
+
+    if (entries.size() <= 256)
+    {
+        // Entry 0 is the gif's transparent colour, unless the gradient needs all 256
+        m_gifColours.transparent = entries.size() < 256;
+        int next = m_gifColours.transparent ? 1 : 0;
+
+        for (size_t n = 0; n < m_palette.size(); ++n)
         {
-            switch (language)
-            {
-            case ID_LANGUAGE_CPP:
+            const Colour& colour = m_palette[n];
+            int& entry = entries[(colour.r << 16) | (colour.g << 8) | colour.b];
+            if (entry < 0)
             {
-                UseCPP(pixelBuffer, 0, m_app->m_heightW, true);
-                break;
+                entry = next++;
+                palette.r[entry] = colour.r;
+                palette.g[entry] = colour.g;
+                palette.b[entry] = colour.b;
             }
-            case ID_LANGUAGE_SSE:
-            {
-                UseSSE(pixelBuffer, 0, m_app->m_heightW, true);
-                break;
-            }
-            case ID_LANGUAGE_AVX:
+
+            m_gifIndices[n] = static_cast<uint8_t>(entry);
+        }
+
+        m_gifFits = true;
+        return;
+    }
+
+    // More colours than a table holds, each frame gets a table of its own in IndexColours
+    m_gifColours.transparent = true;
+    m_gifFits = false;
+}
+
+const GifColours& Fractal::IndexColours(uint8_t* indexBuffer)
+{
+    BuildPalette(m_app->GetGradient());
+    if (m_gifIndices.empty())
+    {
+        BuildGifPalette();
+    }
+
+    const int numPixels = static_cast<int>(m_iterations.size());
+    const unsigned last = static_cast<unsigned>(m_maxIterations);
+
+    if (!m_gifFits)
+    {
+        // Median cut the colours of every 4th pixel, then look up only the counts this frame has
+        // Entry 0 is the transparent colour, so it marks a count that hasn't been looked up yet
+        m_gifSample.resize((numPixels + 3) / 4);
+        for (int i = 0; i < numPixels; i += 4)
+        {
+            m_gifSample[i / 4] = m_palette[std::min(static_cast<unsigned>(m_iterations[i]), last)];
+        }
+
+        GifMakePalette(NULL, reinterpret_cast<const uint8_t*>(m_gifSample.data()), static_cast<uint32_t>(m_gifSample.size()), 1, 8, false, &m_gifColours.palette);
+        std::fill(m_gifIndices.begin(), m_gifIndices.end(), 0);
+
+        for (int i = 0; i < numPixels; ++i)
+        {
+            const unsigned n = std::min(static_cast<unsigned>(m_iterations[i]), last);
+            if (m_gifIndices[n] == 0)
             {
-                UseAVX(pixelBuffer, 0, m_app->m_heightW, true);
-                break;
+                int bestDiff = 1000000;
+                int bestIndex = 1;
+                GifGetClosestPaletteColor(&m_gifColours.palette, m_palette[n].r, m_palette[n].g, m_palette[n].b, &bestIndex, &bestDiff, 1);
+                m_gifIndices[n] = static_cast<uint8_t>(bestIndex);
             }
-            } // Switch
+
+            indexBuffer[i] = m_gifIndices[n];
         }
 
-        break;
+        return m_gifColours;
     }
-    } // Switch
+
+    for (int i = 0; i < numPixels; ++i)
+    {
+        indexBuffer[i] = m_gifIndices[std::min(static_cast<unsigned>(m_iterations[i]), last)];
+    }
+
+    return m_gifColours;
+}
+
+Fractal::RenderStats Fractal::GetRenderStats() const
+{
+    RenderStats stats{};
+    stats.reusedPixels = m_reusedPixels;
+    if (m_tileTicks.empty())
+    {
+        return stats;
+    }
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    const double msPerTick = 1000.0 / static_cast<double>(frequency.QuadPart);
+
+    LONGLONG total = 0, maxTile = 0;
+    for (LONGLONG ticks : m_tileTicks)
+    {
+        total += ticks;
+        maxTile = ticks > maxTile ? ticks : maxTile;
+    }
+
+    LONGLONG maxWorker = 0;
+    for (LONGLONG ticks : m_workerTicks)
+    {
+        maxWorker = ticks > maxWorker ? ticks : maxWorker;
+    }
+
+    for (const KernelCounters& counters : m_workerCounters)
+    {
+        stats.cardioidSkips += counters.cardioidSkips;
+        stats.periodicSkips += counters.periodicSkips;
+        stats.subdivideFills += counters.subdivideFills;
+    }
+
+    stats.references = m_referencesUsed;
+    stats.glitchedPixels = m_glitchedPixels;
+    stats.seriesSkip = m_seriesSkip;
+
+    stats.numTiles = static_cast<int>(m_tileTicks.size());
+    stats.maxTileMs = maxTile * msPerTick;
+    stats.meanTileMs = total * msPerTick / stats.numTiles;
+
+    // Busiest worker vs the average worker, 1.0 is a perfect split
+    double meanWorker = static_cast<double>(total) / m_workerTicks.size();
+    stats.workerImbalance = meanWorker > 0 ? maxWorker / meanWorker : 1.0;
+
+    return stats;
 }
 
-void Fractal::Draw(HDC hdc, Colour* pixelBuffer, GifWriter* gif, bool recording)
+void Fractal::Draw(HDC hdc, Colour* pixelBuffer)
 {
     // Define the bitmap
     BITMAPINFO bmpInfo;
@@ -462,63 +1148,192 @@ void Fractal::Draw(HDC hdc, Colour* pixelBuffer, GifWriter* gif, bool recording)
         &bmpInfo,                    // Bitmap information
         DIB_RGB_COLORS               // Color format (RGB)
     );
-
-    if (recording)
-    {
-        GifWriteFrame(gif, (uint8_t*)pixelBuffer, m_app->m_widthW, m_app->m_heightW, m_app->m_gifDelay);
-    }
 }
 
 void Fractal::ZoomScreen(ZoomType zoomType)
 {
-    const double xRange = m_xMax - m_xMin, yRange = m_yMax - m_yMin;
-    const double midPx = (m_xMax + m_xMin) / 2, midPy = (m_yMax + m_yMin) / 2;
-    double dx = 0, dy = 0;
-
     // Zoom in/out according to the zoom factor
+    // The centre stays put, only the size changes
     switch (zoomType)
     {
     case ZoomType::ZOOM_IN:
     {
-        // Calculating the change in x and y
-        // Based on the zoom factor
-        dx = xRange / m_zoomFactor / 2;
-        dy = yRange / m_zoomFactor / 2;
+        m_xRange /= m_zoomFactor;
+        m_yRange /= m_zoomFactor;
 
         break;
     }
     case ZoomType::ZOOM_OUT:
     {
-        // Update the boundaries of the complex plane
-        // Based on the zoom factor
-        dx = xRange * m_zoomFactor / 2;
-        dy = yRange * m_zoomFactor / 2;
+        m_xRange *= m_zoomFactor;
+        m_yRange *= m_zoomFactor;
 
         break;
     }
     } // Switch
 
-    // Updating x/y values with changes
-    m_xMin = midPx - dx;
-    m_xMax = midPx + dx;
-    m_yMin = midPy - dy;
-    m_yMax = midPy + dy;
+    UpdateBounds();
 }
 
 void Fractal::MoveScreen(POINT* clickPoint)
 {
-    // Finding the current ranges of the window
-    const double xRange = m_xMax - m_xMin, yRange = m_yMax - m_yMin;
-
-    // Mapping the window pos to a complex plane pos
+    // Mapping the window pos to an offset from the current centre
     // This will be the new center of the screen
-    double xMouse = m_xMin + (clickPoint->x / static_cast<double>(m_app->m_widthW)) * (xRange);
-    double yMouse = m_yMin + (clickPoint->y / static_cast<double>(m_app->m_heightW)) * (yRange);
-
-    // Update the boundaries of the complex plane
-    // Based on the pos of the mouse click
-    m_xMin = xMouse - xRange / 2.0;
-    m_xMax = xMouse + xRange / 2.0;
-    m_yMin = yMouse - yRange / 2.0;
-    m_yMax = yMouse + yRange / 2.0;
-}
\ No newline at end of file
+    // The offset is a whole number of pixels, so the new frame's pixels sit on the old frame's and can be copied
+    int xShift = clickPoint->x - m_app->m_widthW / 2;
+    int yShift = clickPoint->y - m_app->m_heightW / 2;
+    double xOffset = xShift * (m_xRange / static_cast<double>(m_app->m_widthW));
+    double yOffset = yShift * (m_yRange / static_cast<double>(m_app->m_heightW));
+
+    // Moving the centre in high precision so deep zooms keep their place
+    m_centreX += FixedPoint(xOffset);
+    m_centreY += FixedPoint(yOffset);
+
+    UpdateBounds();
+}
+
+void Fractal::UpdateBounds()
+{
+    const double xMid = m_centreX.ToDouble(), yMid = m_centreY.ToDouble();
+
+    m_xMin = xMid - m_xRange / 2;
+    m_xMax = xMid + m_xRange / 2;
+    m_yMin = yMid - m_yRange / 2;
+    m_yMax = yMid + m_yRange / 2;
+}
+
+bool Fractal::MapLastFrame(double dx, double dy, bool useFloat)
+{
+    // The last frame has to be the same size, and in the same precision
+    if (!m_lastViewValid || m_lastView.useFloat != useFloat ||
+        m_lastView.width != m_app->m_widthW || m_lastView.height != m_app->m_heightW)
+    {
+        return false;
+    }
+
+    // A column of this frame at xMin + x dx lands on column u of the last one, it is only reused
+    // if u is (to within rounding) a whole column of it
+    // Zooming by 1.5 lines up every third column going in and every other one coming out
+    auto mapAxis = [this](std::vector<int>& source, int size, double min, double step, double lastMin, double lastStep)
+    {
+        int mapped = 0;
+        source.resize(size);
+
+        for (int i = 0; i < size; ++i)
+        {
+            double u = (min + i * step - lastMin) / lastStep;
+            double nearest = std::floor(u + 0.5);
+
+            source[i] = -1;
+            if (nearest >= 0 && nearest < size && std::abs(u - nearest) < m_reuseTolerance)
+            {
+                source[i] = static_cast<int>(nearest);
+                ++mapped;
+            }
+        }
+
+        return mapped;
+    };
+
+    int columns = mapAxis(m_sourceColumns, m_app->m_widthW, m_xMin, dx, m_lastView.xMin, m_lastView.dx);
+    int rows = mapAxis(m_sourceRows, m_app->m_heightW, m_yMin, dy, m_lastView.yMin, m_lastView.dy);
+
+    return columns > 0 && rows > 0;
+}
+
+bool Fractal::InPass(int x, int y) const
+{
+    if (x % m_passStep != 0 || y % m_passStep != 0)
+    {
+        return false;
+    }
+
+    // The coarser passes already have these
+    return m_coarserStep == 0 || x % m_coarserStep != 0 || y % m_coarserStep != 0;
+}
+
+void Fractal::FillPass(int* iterationBuffer) const
+{
+    const int width = m_app->m_widthW;
+
+    // Computed or copied pixels keep their counts, the next passes only write the rest
+    for (int y = 0; y < m_app->m_heightW; ++y)
+    {
+        const bool rowCopied = m_reuseFrame && m_sourceRows[y] >= 0;
+        int* row = iterationBuffer + y * width;
+
+        if (y % m_passStep == 0)
+        {
+            // Spreading every sample along its block
+            for (int x = 0; x < width; x += m_passStep)
+            {
+                const int end = x + m_passStep < width ? x + m_passStep : width;
+                for (int i = x + 1; i < end; ++i)
+                {
+                    if (!rowCopied || m_sourceColumns[i] < 0)
+                    {
+                        row[i] = row[x];
+                    }
+                }
+            }
+        }
+        else
+        {
+            // Then the sample row (filled in already) down the block
+            const int* sampleRow = iterationBuffer + (y - y % m_passStep) * width;
+            if (!rowCopied)
+            {
+                std::copy(sampleRow, sampleRow + width, row);
+                continue;
+            }
+
+            for (int x = 0; x < width; ++x)
+            {
+                if (m_sourceColumns[x] < 0)
+                {
+                    row[x] = sampleRow[x];
+                }
+            }
+        }
+    }
+}
+
+int Fractal::CopyLastFrame(int* iterationBuffer)
+{
+    const int width = m_app->m_widthW;
+    int copied = 0;
+
+    for (int y = 0; y < m_app->m_heightW; ++y)
+    {
+        if (m_sourceRows[y] < 0)
+        {
+            continue;
+        }
+
+        const int* source = m_lastIterations.data() + m_sourceRows[y] * width;
+        int* row = iterationBuffer + y * width;
+
+        // Columns that map onto consecutive columns go over in one copy
+        // Scrolling makes the whole overlap of a row one run, zooming leaves runs of one
+        for (int x = 0; x < width;)
+        {
+            if (m_sourceColumns[x] < 0)
+            {
+                ++x;
+                continue;
+            }
+
+            int run = 1;
+            while (x + run < width && m_sourceColumns[x + run] == m_sourceColumns[x] + run)
+            {
+                ++run;
+            }
+
+            std::copy(source + m_sourceColumns[x], source + m_sourceColumns[x] + run, row + x);
+            copied += run;
+            x += run;
+        }
+    }
+
+    return copied;
+}
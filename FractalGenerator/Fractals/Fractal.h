@@ -11,6 +11,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <thread>
 #include <vector>
 #include <string>
@@ -18,12 +19,25 @@
 #include <functional>
 #include <immintrin.h>
 #include <emmintrin.h>
-#include "../Colour.h"
+#include "Simd.h"
+#include "Periodicity.h"
+#include "HighPrecision.h"
+#include "Perturbation.h"
+#include "DoubleDouble.h"
 #include "../Gif.h"
+#include "../Colour.h"
 #include "../Resource.h"
 
 class App;
 
+// A colour table for recording counts straight to a gif
+// Entry 0 is left free for the transparent colour when the gradient has room for it
+struct GifColours
+{
+    GifPalette palette;
+    bool transparent;
+};
+
 class Fractal
 {
 private:
@@ -31,6 +45,58 @@ private:
 
     double m_xMin, m_xMax, m_yMin, m_yMax;
 
+    // The view is kept as a high precision centre and a size
+    // m_xMin...m_yMax are worked out from them, but past double precision only the centre is exact
+    FixedPoint m_centreX, m_centreY;
+    double m_xRange, m_yRange;
+
+    // Iteration count of every pixel from the last render, the colouring pass works from these
+    // Deep zooms mark glitched pixels with -1 until a later reference fixes them
+    std::vector<int> m_iterations;
+
+    // The frame before, and where in the plane its pixels were sampled
+    // A new frame copies every pixel that lands on one of these samples instead of iterating it
+    struct FrameView
+    {
+        double xMin, yMin;
+        double dx, dy;
+        int width, height;
+        bool useFloat;
+    };
+    std::vector<int> m_lastIterations;
+    FrameView m_lastView{};
+    bool m_lastViewValid = false;
+
+    // Column and row of the last frame each column and row of this frame was sampled at, -1 for none
+    std::vector<int> m_sourceColumns, m_sourceRows;
+    bool m_reuseFrame = false;
+    int m_reusedPixels = 0;
+
+    // The pass being rendered, pixels on the m_passStep grid that weren't on the coarser grid
+    // of the pass before (0 for none)
+    int m_passStep = 1;
+    int m_coarserStep = 0;
+
+    // The selected gradient baked for every count 0...m_maxIterations, rebuilt when the gradient changes
+    std::vector<Colour> m_palette;
+    UINT m_paletteGradient = 0;
+
+    // The baked palette as a gif colour table, and the table entry for every count
+    // Built the first time a frame is recorded from counts, emptied when the palette is rebuilt
+    // Gradients with too many colours to fit get a table per frame, cut from a sample of its pixels
+    GifColours m_gifColours{};
+    std::vector<uint8_t> m_gifIndices;
+    bool m_gifFits = true;
+    std::vector<Colour> m_gifSample;
+
+    // Deep zoom state for the current frame
+    ReferenceOrbit m_reference;
+    ReferenceOrbit m_centreReference; // The view centre's orbit, put aside while a pass redoes its glitches
+    double m_refOffsetX = 0, m_refOffsetY = 0; // Where the reference sits relative to the view centre
+    int m_referencesUsed = 0;
+    int m_glitchedPixels = 0;
+    int m_seriesSkip = 0;
+
 protected:
     // Fractal iterations
     const int m_maxIterations = 10000;
@@ -38,21 +104,61 @@ protected:
     // Escape boundary value
     const float m_rMax = 4.0;
 
-    // SSE and AVX
-    // SSE uses 128 bit reg's --> fits 2 64 bit doubles, and 4 32 bit floats
-    // AVX uses 256 bit reg's --> fits 4 64 bit doubles, and 8 32 bit floats
-    const short int m_sseVectSizeD = 2;
-    const short int m_sseVectSizeF = 4;
-    const short int m_avxVectSizeD = 6;
-    const short int m_avxVectSizeF = 8;
-
     // Switching condition float --> double
     // When resolution gets low
     const float m_floatToDouble = 0.0001f;
 
+    // Switching condition double --> double-double
+    // Around here the pixel spacing gets down to a few ulps of the coordinates
+    const double m_doubleToDoubleDouble = 1e-12;
+
+    // Switching condition double --> perturbation, for the fractals that can deep zoom
+    // Perturbation (with the series skip) beat the double-double kernels at every depth we timed,
+    // so these go straight to it ahead of double-double and only use double-double for glitches
+    const double m_doubleToPerturbation = 1e-10;
+
+    // Most reference orbits a deep zoom frame will use to fix glitched pixels
+    const int m_maxReferences = 8;
+
+    // Series approximation terms, and how far its result may drift (relative) before we stop skipping
+    static const int m_seriesTerms = 8;
+    const double m_seriesTolerance = 1e-8;
+
     // Zoom factor
     const float m_zoomFactor = 1.5f;
 
+    // Orbits that come back this close to an earlier point are taken to be periodic (inside the set)
+    // Scaled from the pixel spacing at the start of every render, so it tightens as we zoom in
+    double m_periodTolerance = 0.0;
+    const double m_periodToleranceScale = 0.001;
+
+    // How far (in the last frame's pixels) a sample may sit from this frame's pixel and still be reused
+    const double m_reuseTolerance = 0.001;
+
+    // Width and height of the square tiles handed out to the render workers
+    static const int m_tileSize = 32;
+
+    // Rectangle subdivision stops splitting at this size and computes the rest of the rectangle
+    static const int m_subdivideMinSize = 8;
+
+    // Spacing of the samples in the first pass of a progressive render, halved every pass after
+    static const int m_progressiveStep = 8;
+
+    // Counters bumped by the kernels
+    // Kept per thread so the workers don't fight over a cache line, RenderTiles collects them after every tile
+    struct KernelCounters
+    {
+        int cardioidSkips; // Pixels found inside the main cardioid/period-2 bulb without iterating
+        int periodicSkips; // Pixels retired early because their orbit became periodic
+        int subdivideFills; // Pixels filled in by rectangle subdivision without iterating
+    };
+    static thread_local KernelCounters s_counters;
+
+    // Cost of each tile and busy time of each worker from the last frame (in QPC ticks)
+    std::vector<LONGLONG> m_tileTicks;
+    std::vector<LONGLONG> m_workerTicks;
+    std::vector<KernelCounters> m_workerCounters;
+
 public:
     enum class ZoomType
     {
@@ -60,65 +166,229 @@ public:
         ZOOM_OUT
     };
 
-private:
-    // FOR RENDERING WITH CPP //
+    // Load balancing and kernel summary of the last frame
+    struct RenderStats
+    {
+        int numTiles;
+        double maxTileMs;
+        double meanTileMs;
+        double workerImbalance; // Busiest worker's time / average worker's time
+        int cardioidSkips;
+        int periodicSkips;
+        int subdivideFills;
+        int reusedPixels;   // Pixels copied from the last frame
+        int references;     // Reference orbits used (deep zoom only)
+        int glitchedPixels; // Pixels still glitched after the last reference
+        int seriesSkip;     // Iterations every pixel skipped with the series approximation
+    };
 
-    // Determining iterations with CPP with floats
-    virtual int GetCPPIterF(float, float) const = 0;
+private:
+    // FOR RENDERING WITH THE KERNEL FAMILIES //
+
+    // Computing a list of pixels with the kernels of a language, FractalKernels writes these for every fractal
+    // stream swaps in the lane refill kernels, otherwise a block of lanes is run to the end together
+    virtual void IterateJob(
+        const StreamJob& job,
+        bool useFloat,
+        UINT language,
+        bool stream) const = 0;
+
+    // Feed a tile's pixels through the kernels of the selected language
+    // Pixels copied from the last frame are skipped when m_reuseFrame is set
+    void UseKernels(
+        int* iterationBuffer,
+        int xStart,
+        int xEnd,
+        int yStart,
+        int yEnd,
+        bool useFloat,
+        bool stream);
 
-    // Determining iterations with CPP with doubles
-    virtual int GetCPPIterD(double, double) const = 0;
+    void UseBlocks(
+        int* iterationBuffer,
+        int xStart,
+        int xEnd,
+        int yStart,
+        int yEnd,
+        bool useFloat);
 
-    // Determining if a point is apart of the fractal in C++
-    void UseCPP(
-        Colour* pixelBuffer,
+    void UseStream(
+        int* iterationBuffer,
+        int xStart,
+        int xEnd,
         int yStart,
         int yEnd,
         bool useFloat);
 
 
-    // FOR RENDERING WITH SSE //
+    // FOR RENDERING WITH DOUBLE-DOUBLE //
 
-    // Determining iterations with SSE with floats
-    virtual __m128i GetSSEIterF(__m128, __m128) const = 0;
+    // Streaming kernels in double-double, for views too small for doubles
+    // Fractals without double-double formulas fall back to their double kernels
+    virtual void IterateJobDD(
+        const StreamJobDD& job,
+        UINT language) const = 0;
 
-    // Determining iterations with SSE with doubles
-    virtual __m128i GetSSEIterD(__m128d, __m128d) const = 0;
+    // Iterating a list of pixels (at most a tile's worth) in double-double with the kernels of the selected language
+    void DoubleDoublePixels(
+        int* iterationBuffer,
+        const int* pixels,
+        int numPixels);
 
-    // Determining if a point is apart of the fractal in SSE
-    void UseSSE(
-        Colour* pixelBuffer,
+    // Determining a tile in double-double
+    void UseDoubleDouble(
+        int* iterationBuffer,
+        int xStart,
+        int xEnd,
         int yStart,
         int yEnd,
         bool useFloat);
 
 
-    // FOR RENDERING WITH AVX //
+    // FOR RENDERING WITH RECTANGLE SUBDIVISION (MARIANI-SILVER) //
 
-    // Determining iterations with AVX with floats
-    virtual __m256i GetAVXIterF(__m256, __m256) const = 0;
+    // Iterations of one tile, -1 for pixels not computed (or filled in) yet
+    struct SubdivideTile
+    {
+        int iterations[m_tileSize * m_tileSize];
+        int xStart, yStart;
+        int width, height;
+        bool useFloat;
+        UINT language;
+    };
 
-    // Determining iterations with AVX with doubles
-    virtual __m256i GetAVXIterD(__m256d, __m256d) const = 0;
+    // Compute the border of a rectangle (tile relative, inclusive), fill it if the whole border
+    // has the same iteration count, otherwise split it into four and recurse
+    void SubdivideRect(
+        SubdivideTile& tile,
+        int x0,
+        int x1,
+        int y0,
+        int y1);
+
+    // Computing any pixels of a rectangle that are still unknown
+    void ComputeRect(
+        SubdivideTile& tile,
+        int x0,
+        int x1,
+        int y0,
+        int y1,
+        bool borderOnly);
+
+    // Determining a tile by rectangle subdivision
+    void UseSubdivide(
+        int* iterationBuffer,
+        int xStart,
+        int xEnd,
+        int yStart,
+        int yEnd,
+        bool useFloat);
 
-    // Determining if a point is apart of the fractal in AVX
-    void UseAVX(
-        Colour* pixelBuffer,
+
+    // FOR RENDERING DEEP ZOOMS (PERTURBATION) //
+
+    // Power d of z^d + c for the perturbation kernels, 0 if the fractal can't deep zoom
+    virtual int GetDeepZoomPower() const;
+
+    // Computing the reference orbit at c = (cx, cy) in high precision
+    void ComputeReference(
+        const FixedPoint& cx,
+        const FixedPoint& cy);
+
+    // Working out how far the series approximation can take every pixel within radius of the reference
+    void ComputeSeries(
+        double radius);
+
+    // Iterating a list of pixels (at most a tile's worth) against the current reference
+    void DeepZoomPixels(
+        int* iterationBuffer,
+        const int* pixels,
+        int numPixels);
+
+    // Determining a tile with perturbation
+    void UseDeepZoom(
+        int* iterationBuffer,
+        int xStart,
+        int xEnd,
         int yStart,
         int yEnd,
         bool useFloat);
 
+    // Computing the reference orbit and series at the view centre, once for every pass of the frame
+    void PrepareDeepZoom();
+
+    // Rendering the current pass with perturbation, then redoing its glitched pixels with new references
+    // The centre reference is back in place afterwards for the next pass
+    void RenderDeepZoom(
+        int* iterationBuffer,
+        int numWorkers);
+
 
     // HELPER FUNCTIONS //
 
-    // Map iterations to a gradient
+    // Working out m_xMin...m_yMax from the centre and size
+    void UpdateBounds();
+
+    // Working out m_sourceColumns/m_sourceRows against the last frame, false if none of it can be reused
+    bool MapLastFrame(
+        double dx,
+        double dy,
+        bool useFloat);
+
+    // Whether a pixel is computed in the current pass
+    bool InPass(
+        int x,
+        int y) const;
+
+    // Giving every pixel the current pass hasn't reached the count of the sample at the top left
+    // of its block, so the pass can be shown
+    void FillPass(
+        int* iterationBuffer) const;
+
+    // Copying every pixel the map finds from m_lastIterations, a run of columns at a time
+    // Returns how many were copied
+    int CopyLastFrame(
+        int* iterationBuffer);
+
+    // One of the Use* functions, run over a single tile
+    using TileKernel = void (Fractal::*)(int*, int, int, int, int, bool);
+
+    // Split the image into tiles and render them (on the thread pool if numWorkers > 0)
+    void RenderTiles(
+        int* iterationBuffer,
+        TileKernel kernel,
+        bool useFloat,
+        int numWorkers);
+
+    // DeepZoomPixels or DoubleDoublePixels, run over a list of pixels
+    using PixelKernel = void (Fractal::*)(int*, const int*, int);
+
+    // Run a kernel over a list of pixels a tile's worth at a time (on the thread pool if numWorkers > 0)
+    // The pieces not started yet are skipped once the view is stale
+    void RenderPixels(
+        int* iterationBuffer,
+        const std::vector<int>& pixels,
+        PixelKernel kernel,
+        int numWorkers);
+
+    // Map iterations to a gradient, only used to bake the palette
     void MapColour(
         Colour* pixelBuffer,
-        uint8_t n);
+        int n,
+        UINT gradient) const;
+
+    // Baking a gradient into m_palette, if it isn't already
+    void BuildPalette(
+        UINT gradient);
+
+    // Fitting m_palette into a gif colour table, filling m_gifColours and m_gifIndices,
+    // or finding it doesn't fit
+    void BuildGifPalette();
 
 public:
     Fractal(std::shared_ptr<App> app, double xMin, double xMax, double yMin, double yMax)
-        : m_app(std::move(app)), m_xMin(xMin), m_xMax(xMax), m_yMin(yMin), m_yMax(yMax)
+        : m_app(std::move(app)), m_xMin(xMin), m_xMax(xMax), m_yMin(yMin), m_yMax(yMax),
+        m_centreX((xMin + xMax) / 2), m_centreY((yMin + yMax) / 2), m_xRange(xMax - xMin), m_yRange(yMax - yMin)
     {
     }
 
@@ -127,14 +397,23 @@ public:
     }
 
     // Function to render the fractal (May use multithreading depending on user selection)
-    void Render(Colour* pixelBuffer);
+    // Returns false if it was given up part way for a newer view
+    bool Render(Colour* pixelBuffer);
+
+    // Colouring the last render's iteration counts with the selected gradient, no orbits are recomputed
+    void Recolour(Colour* pixelBuffer);
 
-    // Transferring the pixelBuffer bitmap to the main screen and writing to the gif
+    // The gif colour table entry of each of the last render's pixels, one byte each, so a recording
+    // can skip quantising. Returns the table the entries are in
+    const GifColours& IndexColours(uint8_t* indexBuffer);
+
+    // Per tile timings and kernel counters of the last render
+    RenderStats GetRenderStats() const;
+
+    // Transferring the pixelBuffer bitmap to the main screen
     void Draw(
         HDC hdc,
-        Colour* pixelBuffer,
-        GifWriter* gif,
-        bool recording);
+        Colour* pixelBuffer);
 
     // Zooming in on the current fractal
     void ZoomScreen(ZoomType zoom);
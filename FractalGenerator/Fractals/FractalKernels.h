@@ -0,0 +1,312 @@
+/*********************************************************************************************
+**
+**	File Name:		fractalkernels.h
+**	Description:	This is the header file that contains the class template that writes every
+**                  kernel family (C++, SSE, AVX, AVX-512, float and double) for a fractal from
+**                  its one Formula, and the block kernel they share
+**
+**	Author:			Clarke Needles
+**	Created:		10/17/2026
+**
+**********************************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include "Fractal.h"
+
+// Classic escape time loop, the pixels of the job are taken L at a time and every lane of a block
+// iterates until the whole block is done. The last block of a job may be short, its spare lanes
+// repeat the last pixel and are masked off.
+// An optional Formula::InteriorMask<V>(cx, cy, valid) lets lanes skip the loop entirely.
+// Returns how many pixels were retired by cycle detection, like StreamKernel.
+template<class V, class Formula>
+int BlockKernel(const StreamJob& job, const Formula& formula, int maxIterations, float rMax, double periodTolerance)
+{
+    using Reg = typename V::Reg;
+    using Scalar = typename V::Scalar;
+    using Mask = typename V::Mask;
+    constexpr int L = V::Lanes;
+
+    alignas(64) Scalar cxLane[L], cyLane[L], nLane[L], laneIndex[L];
+    int retired = 0;
+
+    for (int lane = 0; lane < L; ++lane)
+    {
+        laneIndex[lane] = static_cast<Scalar>(lane);
+    }
+
+    const Reg vrMax = V::Set1(static_cast<Scalar>(rMax));
+    const Reg vMaxIter = V::Set1(static_cast<Scalar>(maxIterations));
+    const Reg zero = V::Zero();
+    const Reg one = V::Set1(1);
+    const Reg lanes = V::Load(laneIndex);
+    const Mask none = V::CmpLt(zero, zero);
+
+    // Jobs come a row at a time, so the row is only worked out (with a divide) when it changes
+    int rowStart = 0, rowEnd = 0;
+    double rowY = 0;
+
+    for (int first = 0; first < job.numPixels; first += L)
+    {
+        int count = std::min(L, job.numPixels - first);
+
+        for (int lane = 0; lane < L; ++lane)
+        {
+            int pixel = job.pixels[first + std::min(lane, count - 1)];
+            if (pixel < rowStart || pixel >= rowEnd)
+            {
+                int row = pixel / job.width;
+                rowStart = row * job.width;
+                rowEnd = rowStart + job.width;
+                rowY = job.yMin + row * job.dy;
+            }
+
+            cxLane[lane] = static_cast<Scalar>(job.xMin + (pixel - rowStart) * job.dx);
+            cyLane[lane] = static_cast<Scalar>(rowY);
+        }
+
+        const Reg cx = V::Load(cxLane), cy = V::Load(cyLane);
+        const Mask valid = V::CmpLt(lanes, V::Set1(static_cast<Scalar>(count)));
+
+        Mask inside = none;
+        if constexpr (requires { Formula::template InteriorMask<V>(cx, cy, valid); })
+        {
+            inside = Formula::template InteriorMask<V>(cx, cy, valid);
+        }
+
+        // Lanes whose orbit becomes periodic are retired along with the inside ones
+        // Once a lane drops out it stays out, some orbits (Nova's) come back inside the radius
+        Mask active = V::AndNot(inside, valid);
+        Mask periodic = none;
+        Reg n = zero;
+
+        if (V::MoveMask(active))
+        {
+            Orbit<V> z;
+            z.x = z.y = z.xprev = z.yprev = z.r = zero;
+            VectorPeriodCheck<V, IsSecondOrder<Formula>> period(static_cast<Scalar>(periodTolerance));
+
+            for (int i = 0; i < maxIterations; ++i)
+            {
+                active = V::And(active, V::CmpLt(z.r, vrMax));
+                if (!V::MoveMask(active)) break;
+
+                formula.template Step<V>(z, cx, cy);
+                n = V::MaskAdd(n, active, n, one);
+
+                // Still running lanes that came back around will never escape
+                Mask hit = V::And(active, period.Update(z));
+                periodic = V::Or(periodic, hit);
+                active = V::AndNot(hit, active);
+            }
+
+            retired += std::popcount(static_cast<unsigned>(V::MoveMask(periodic)));
+        }
+
+        // Retired lanes report the full count
+        n = V::MaskMov(n, V::Or(inside, periodic), vMaxIter);
+        V::Store(nLane, n);
+
+        for (int lane = 0; lane < count; ++lane)
+        {
+            job.iterations[first + lane] = static_cast<int>(nLane[lane]);
+        }
+    }
+
+    return retired;
+}
+
+// Every kernel of a fractal, instantiated from the fractal's nested structs
+//   Formula::Step<V>(orbit, cx, cy)            One iteration, for any of the register wrappers
+//   Formula::Interior(cx, cy)                  Optional, the pixel is provably inside the set
+//   Formula::InteriorMask<V>(cx, cy, valid)    Optional, the same test across a block of lanes
+//   FormulaDD::Step<V>(orbitDD, cx, cy)        Optional, the iteration in double-double
+// A fractal with parameters (Multibrot's exponent) hides VisitFormula/VisitFormulaDD instead, and
+// hands the kernels whichever formula object the parameters call for
+// Derived has to make FractalKernels<Derived> a friend, and explicitly instantiate it in its .cpp
+// (where Step is defined)
+template<class Derived>
+class FractalKernels : public Fractal
+{
+private:
+    // Running a job through the kernels of one register wrapper
+    template<class V, class Formula>
+    void Iterate(
+        const StreamJob& job,
+        const Formula& formula,
+        bool stream) const;
+
+    template<class V>
+    void Iterate(
+        const StreamJob& job,
+        bool stream) const;
+
+    // False when the fractal has no double-double formula
+    template<class V>
+    bool IterateDD(
+        const StreamJobDD& job) const;
+
+    void IterateJob(
+        const StreamJob& job,
+        bool useFloat,
+        UINT language,
+        bool stream) const override;
+
+    void IterateJobDD(
+        const StreamJobDD& job,
+        UINT language) const override;
+
+protected:
+    // Calls visit with the formula to render with, the nested structs unless Derived hides these
+    template<class Visit>
+    void VisitFormula(
+        Visit&& visit) const;
+
+    template<class Visit>
+    bool VisitFormulaDD(
+        Visit&& visit) const;
+
+public:
+    using Fractal::Fractal;
+};
+
+// Defined out of the class, so the extern template in each fractal's header keeps them out of
+// every other translation unit
+
+template<class Derived>
+template<class V, class Formula>
+void FractalKernels<Derived>::Iterate(const StreamJob& job, const Formula& formula, bool stream) const
+{
+    if constexpr (V::Lanes == 1)
+    {
+        // One lane has nothing to refill, both modes are the same loop
+        s_counters.periodicSkips += BlockKernel<V>(job, formula, m_maxIterations, m_rMax, m_periodTolerance);
+    }
+    else if (stream)
+    {
+        // The AVX-512 masks are registers of their own (with masked loads), the other widths keep them in the float registers
+        if constexpr (requires { &V::MaskLoad; })
+        {
+            s_counters.periodicSkips += StreamKernelMasked<V>(job, formula, m_maxIterations, m_rMax, m_periodTolerance);
+        }
+        else
+        {
+            s_counters.periodicSkips += StreamKernel<V>(job, formula, m_maxIterations, m_rMax, m_periodTolerance);
+        }
+    }
+    else
+    {
+        s_counters.periodicSkips += BlockKernel<V>(job, formula, m_maxIterations, m_rMax, m_periodTolerance);
+    }
+}
+
+template<class Derived>
+template<class V>
+void FractalKernels<Derived>::Iterate(const StreamJob& job, bool stream) const
+{
+    static_cast<const Derived*>(this)->VisitFormula([&](const auto& formula)
+    {
+        Iterate<V>(job, formula, stream);
+    });
+}
+
+template<class Derived>
+template<class V>
+bool FractalKernels<Derived>::IterateDD(const StreamJobDD& job) const
+{
+    return static_cast<const Derived*>(this)->VisitFormulaDD([&](const auto& formula)
+    {
+        s_counters.periodicSkips += StreamKernelDD<V>(job, formula, m_maxIterations, m_rMax, m_periodTolerance);
+    });
+}
+
+template<class Derived>
+template<class Visit>
+void FractalKernels<Derived>::VisitFormula(Visit&& visit) const
+{
+    visit(typename Derived::Formula{});
+}
+
+template<class Derived>
+template<class Visit>
+bool FractalKernels<Derived>::VisitFormulaDD(Visit&& visit) const
+{
+    if constexpr (requires { typename Derived::FormulaDD; })
+    {
+        visit(typename Derived::FormulaDD{});
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+template<class Derived>
+void FractalKernels<Derived>::IterateJob(const StreamJob& job, bool useFloat, UINT language, bool stream) const
+{
+    switch (language)
+    {
+    case ID_LANGUAGE_SSE:
+    case ID_LANGUAGE_SSE_MT:
+    {
+        useFloat ? Iterate<SseF>(job, stream) : Iterate<SseD>(job, stream);
+        break;
+    }
+    case ID_LANGUAGE_AVX:
+    case ID_LANGUAGE_AVX_MT:
+    {
+        useFloat ? Iterate<AvxF>(job, stream) : Iterate<AvxD>(job, stream);
+        break;
+    }
+    case ID_LANGUAGE_AVX512:
+    case ID_LANGUAGE_AVX512_MT:
+    {
+        useFloat ? Iterate<Avx512F>(job, stream) : Iterate<Avx512D>(job, stream);
+        break;
+    }
+    default:
+    {
+        useFloat ? Iterate<CppF>(job, stream) : Iterate<CppD>(job, stream);
+        break;
+    }
+    } // Switch
+}
+
+template<class Derived>
+void FractalKernels<Derived>::IterateJobDD(const StreamJobDD& job, UINT language) const
+{
+    bool done = false;
+
+    // The double-double kernel keeps its masks in the float registers, so AVX-512 runs the AVX one
+    switch (language)
+    {
+    case ID_LANGUAGE_SSE:
+    case ID_LANGUAGE_SSE_MT:
+    {
+        done = IterateDD<SseD>(job);
+        break;
+    }
+    case ID_LANGUAGE_AVX:
+    case ID_LANGUAGE_AVX_MT:
+    case ID_LANGUAGE_AVX512:
+    case ID_LANGUAGE_AVX512_MT:
+    {
+        done = IterateDD<AvxD>(job);
+        break;
+    }
+    default:
+    {
+        done = IterateDD<ScalarD>(job);
+        break;
+    }
+    } // Switch
+
+    if (!done)
+    {
+        // Without a double-double formula the hi parts are as close as doubles get
+        StreamJob rounded{ job.pixels, job.numPixels, job.width, job.xMinHi, job.yMinHi, job.dx, job.dy, job.iterations };
+        IterateJob(rounded, false, language, false);
+    }
+}
@@ -0,0 +1,137 @@
+/*********************************************************************************************
+**
+**	File Name:		highprecision.cpp
+**	Description:	This is the file that contains the function definitions for the fixed
+**                  point number
+**
+**	Author:			Clarke Needles
+**	Created:		10/17/2026
+**
+**********************************************************************************************/
+
+#include "highprecision.h"
+
+#include <cmath>
+
+FixedPoint::FixedPoint(double value)
+{
+    // Peel the magnitude off 32 bits at a time, scaling by a power of two is exact
+    double magnitude = std::fabs(value);
+    for (int i = 0; i < m_words; ++i)
+    {
+        double word = std::floor(magnitude);
+        m_data[i] = static_cast<uint32_t>(word);
+        magnitude = (magnitude - word) * 4294967296.0;
+    }
+
+    if (value < 0)
+    {
+        *this = Negate();
+    }
+}
+
+bool FixedPoint::IsNegative() const
+{
+    return (m_data[0] & 0x80000000u) != 0;
+}
+
+FixedPoint FixedPoint::Negate() const
+{
+    FixedPoint result;
+
+    // Invert and add one
+    uint64_t carry = 1;
+    for (int i = m_words - 1; i >= 0; --i)
+    {
+        uint64_t sum = static_cast<uint64_t>(~m_data[i]) + carry;
+        result.m_data[i] = static_cast<uint32_t>(sum);
+        carry = sum >> 32;
+    }
+
+    return result;
+}
+
+double FixedPoint::ToDouble() const
+{
+    const FixedPoint magnitude = IsNegative() ? Negate() : *this;
+
+    // Least significant first so the small words aren't lost
+    double value = 0;
+    for (int i = m_words - 1; i >= 0; --i)
+    {
+        value = value / 4294967296.0 + magnitude.m_data[i];
+    }
+
+    return IsNegative() ? -value : value;
+}
+
+void FixedPoint::ToDoubleDouble(double& hi, double& lo) const
+{
+    // hi is exact as a fixed point number, so what's left over is exactly the part it missed
+    hi = ToDouble();
+    lo = (*this - FixedPoint(hi)).ToDouble();
+}
+
+FixedPoint FixedPoint::operator+(const FixedPoint& other) const
+{
+    FixedPoint result;
+
+    uint64_t carry = 0;
+    for (int i = m_words - 1; i >= 0; --i)
+    {
+        uint64_t sum = static_cast<uint64_t>(m_data[i]) + other.m_data[i] + carry;
+        result.m_data[i] = static_cast<uint32_t>(sum);
+        carry = sum >> 32;
+    }
+
+    return result;
+}
+
+FixedPoint FixedPoint::operator-(const FixedPoint& other) const
+{
+    return *this + other.Negate();
+}
+
+FixedPoint& FixedPoint::operator+=(const FixedPoint& other)
+{
+    *this = *this + other;
+    return *this;
+}
+
+FixedPoint FixedPoint::operator*(const FixedPoint& other) const
+{
+    const bool negative = IsNegative() != other.IsNegative();
+    const FixedPoint a = IsNegative() ? Negate() : *this;
+    const FixedPoint b = other.IsNegative() ? other.Negate() : other;
+
+    // Word i of a times word j of b lands on word i + j of the result
+    // Each 64 bit product is split over two accumulators so none of them can overflow
+    uint64_t acc[2 * m_words] = {};
+    for (int i = 0; i < m_words; ++i)
+    {
+        for (int j = 0; j < m_words; ++j)
+        {
+            uint64_t product = static_cast<uint64_t>(a.m_data[i]) * b.m_data[j];
+            acc[i + j] += product & 0xFFFFFFFFu;
+            if (i + j > 0)
+            {
+                acc[i + j - 1] += product >> 32; // Above the integer word is overflow, dropped
+            }
+        }
+    }
+
+    // Carry up from the bottom, the words past m_words are truncated
+    for (int k = 2 * m_words - 1; k > 0; --k)
+    {
+        acc[k - 1] += acc[k] >> 32;
+        acc[k] &= 0xFFFFFFFFu;
+    }
+
+    FixedPoint result;
+    for (int i = 0; i < m_words; ++i)
+    {
+        result.m_data[i] = static_cast<uint32_t>(acc[i]);
+    }
+
+    return negative ? result.Negate() : result;
+}
@@ -0,0 +1,51 @@
+/*********************************************************************************************
+**
+**	File Name:		highprecision.h
+**	Description:	This is the header file that contains the fixed point number used for the
+**                  deep zoom view centre and reference orbit, where a double runs out of bits
+**
+**	Author:			Clarke Needles
+**	Created:		10/17/2026
+**
+**********************************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+// Two's complement fixed point number
+// Word 0 is the integer part, the rest is fraction (most significant first)
+class FixedPoint
+{
+public:
+    // 32 bit integer part + 224 bits of fraction, about 67 decimal digits after the point
+    static const int m_words = 8;
+
+private:
+    uint32_t m_data[m_words] = {};
+
+private:
+    bool IsNegative() const;
+
+    FixedPoint Negate() const;
+
+public:
+    FixedPoint()
+    {
+    }
+
+    explicit FixedPoint(double value);
+
+    double ToDouble() const;
+
+    // Rounded to a double-double, hi + lo
+    void ToDoubleDouble(double& hi, double& lo) const;
+
+    FixedPoint operator+(const FixedPoint& other) const;
+
+    FixedPoint operator-(const FixedPoint& other) const;
+
+    FixedPoint operator*(const FixedPoint& other) const;
+
+    FixedPoint& operator+=(const FixedPoint& other);
+};
@@ -11,162 +11,94 @@
 
 #include "mandelbrot.h"
 
-int Mandelbrot::GetCPPIterF(float xval, float yval) const
-{
-    float x = 0.0, y = 0.0;
-    float r = 0;
-    int n = 0;
+#include <bit>
 
-    while (r < m_rMax && n < m_maxIterations)
+template<class T>
+bool Mandelbrot::InCardioidOrBulb(T xval, T yval)
+{
+    // Main cardioid: q(q + (x - 1/4)) <= y^2 / 4, where q = (x - 1/4)^2 + y^2
+    T xq = xval - T(0.25);
+    T y2 = yval * yval;
+    T q = xq * xq + y2;
+    if (q * (q + xq) <= T(0.25) * y2)
     {
-        float x2 = x * x;
-        float y2 = y * y;
-        float temp = x2 - y2 + xval;
-        r = x2 + y2;
-
-        y = 2 * x * y + yval;
-        x = temp;
-        ++n;
+        return true;
     }
 
-    return n;
+    // Period-2 bulb: circle of radius 1/4 around -1
+    T xb = xval + T(1);
+    return xb * xb + y2 <= T(0.0625);
 }
 
-int Mandelbrot::GetCPPIterD(double xval, double yval) const
+template<class V>
+typename V::Mask Mandelbrot::CardioidOrBulbMask(typename V::Reg xval, typename V::Reg yval)
 {
-    double x = 0.0, y = 0.0;
-    double r = 0;
-    int n = 0;
+    using Scalar = typename V::Scalar;
 
-    while (r < m_rMax && n < m_maxIterations)
-    {
-        double x2 = x * x;
-        double y2 = y * y;
-        double temp = x2 - y2 + xval;
-        r = x2 + y2;
-
-        y = 2 * x * y + yval;
-        x = temp;
-        ++n;
-    }
-    return n;
+    auto xq = V::Sub(xval, V::Set1(Scalar(0.25)));
+    auto y2 = V::Mul(yval, yval);
+    auto q = V::Add(V::Mul(xq, xq), y2);
+    auto cardioid = V::CmpLe(V::Mul(q, V::Add(q, xq)), V::Mul(V::Set1(Scalar(0.25)), y2));
+
+    auto xb = V::Add(xval, V::Set1(Scalar(1)));
+    auto bulb = V::CmpLe(V::Add(V::Mul(xb, xb), y2), V::Set1(Scalar(0.0625)));
+
+    return V::Or(cardioid, bulb);
 }
 
-__m128i Mandelbrot::GetSSEIterF(__m128 xval, __m128 yval) const
+template<class V>
+void Mandelbrot::Formula::Step(Orbit<V>& z, typename V::Reg cx, typename V::Reg cy)
 {
-    const __m128 rMax = _mm_set1_ps(m_rMax);
-    __m128i n = _mm_setzero_si128();
-    __m128 x = _mm_setzero_ps();
-    __m128 y = _mm_setzero_ps();
-    __m128 x2 = _mm_setzero_ps();
-    __m128 y2 = _mm_setzero_ps();
-    __m128 xy = _mm_setzero_ps();
-    __m128 r = _mm_setzero_ps();
-
-    for (int i = 0; i < m_maxIterations; ++i)
-    {
-        __m128 cmp = _mm_cmp_ps(rMax, r, _CMP_GT_OQ);
-        if (!_mm_movemask_ps(cmp)) break;
-
-        x2 = _mm_mul_ps(x, x);
-        y2 = _mm_mul_ps(y, y);
-        xy = _mm_mul_ps(x, y);
-        x = _mm_add_ps(_mm_sub_ps(x2, y2), xval);
-        y = _mm_add_ps(_mm_add_ps(xy, xy), yval);
-        r = _mm_add_ps(x2, y2);
-
-        __m128i bn = _mm_castps_si128(cmp);
-        n = _mm_add_epi16(n, bn);
-    }
-
-    return n;
+    auto x2 = V::Mul(z.x, z.x);
+    auto y2 = V::Mul(z.y, z.y);
+    z.r = V::Add(x2, y2);
+    z.y = V::Fma(V::Add(z.x, z.x), z.y, cy); // 2xy + cy
+    z.x = V::Add(V::Sub(x2, y2), cx);
 }
 
-__m128i Mandelbrot::GetSSEIterD(__m128d xval, __m128d yval) const
+bool Mandelbrot::Formula::Interior(double cx, double cy)
 {
-    const __m128d rMax = _mm_set1_pd(m_rMax);
-    __m128i n = _mm_setzero_si128();
-    __m128d x = _mm_setzero_pd();
-    __m128d y = _mm_setzero_pd();
-    __m128d x2 = _mm_setzero_pd();
-    __m128d y2 = _mm_setzero_pd();
-    __m128d xy = _mm_setzero_pd();
-    __m128d r = _mm_setzero_pd();
-
-    for (int i = 0; i < m_maxIterations; ++i)
+    if (InCardioidOrBulb(cx, cy))
     {
-        __m128d cmp = _mm_cmp_pd(rMax, r, _CMP_GT_OQ);
-        if (!_mm_movemask_pd(cmp)) break;
-
-        x2 = _mm_mul_pd(x, x);
-        y2 = _mm_mul_pd(y, y);
-        xy = _mm_mul_pd(x, y);
-        x = _mm_add_pd(_mm_sub_pd(x2, y2), xval);
-        y = _mm_add_pd(_mm_add_pd(xy, xy), yval);
-        r = _mm_add_pd(x2, y2);
-
-        __m128i bn = _mm_castpd_si128(cmp);
-        n = _mm_add_epi16(n, bn);
+        ++s_counters.cardioidSkips;
+        return true;
     }
-    return n;
+
+    return false;
 }
 
-__m256i Mandelbrot::GetAVXIterF(__m256 xval, __m256 yval) const
+template<class V>
+typename V::Mask Mandelbrot::Formula::InteriorMask(typename V::Reg cx, typename V::Reg cy, typename V::Mask valid)
 {
-    const __m256 rMax = _mm256_set1_ps(m_rMax);
-    __m256i n = _mm256_setzero_si256();
-    __m256 x = _mm256_setzero_ps();
-    __m256 y = _mm256_setzero_ps();
-    __m256 x2 = _mm256_setzero_ps();
-    __m256 y2 = _mm256_setzero_ps();
-    __m256 xy = _mm256_setzero_ps();
-    __m256 r = _mm256_setzero_ps();
-
-    for (int i = 0; i < m_maxIterations; ++i)
+    auto inside = V::And(valid, CardioidOrBulbMask<V>(cx, cy));
+    if (int insideLanes = V::MoveMask(inside))
     {
-        __m256 cmp = _mm256_cmp_ps(rMax, r, _CMP_GT_OQ);
-        if (!_mm256_movemask_ps(cmp)) break;
-
-        x2 = _mm256_mul_ps(x, x);
-        y2 = _mm256_mul_ps(y, y);
-        xy = _mm256_mul_ps(x, y);
-        x = _mm256_add_ps(_mm256_sub_ps(x2, y2), xval);
-        y = _mm256_add_ps(_mm256_add_ps(xy, xy), yval);
-        r = _mm256_add_ps(x2, y2);
-
-        __m256i bn = _mm256_castps_si256(cmp);
-        n = _mm256_add_epi16(n, bn);
+        s_counters.cardioidSkips += std::popcount(static_cast<unsigned>(insideLanes));
     }
 
-    return n;
+    return inside;
 }
 
-__m256i Mandelbrot::GetAVXIterD(__m256d xval, __m256d yval) const
+template<class V>
+void Mandelbrot::FormulaDD::Step(OrbitDD<V>& z, const DD<V>& cx, const DD<V>& cy)
 {
-    const __m256d rMax = _mm256_set1_pd(m_rMax);
-    __m256i n = _mm256_setzero_si256();
-    __m256d x = _mm256_setzero_pd();
-    __m256d y = _mm256_setzero_pd();
-    __m256d x2 = _mm256_setzero_pd();
-    __m256d y2 = _mm256_setzero_pd();
-    __m256d xy = _mm256_setzero_pd();
-    __m256d r = _mm256_setzero_pd();
-
-    for (int i = 0; i < m_maxIterations; ++i)
-    {
-        __m256d cmp = _mm256_cmp_pd(rMax, r, _CMP_GT_OQ);
-        if (!_mm256_movemask_pd(cmp)) break;
-
-        x2 = _mm256_mul_pd(x, x);
-        y2 = _mm256_mul_pd(y, y);
-        xy = _mm256_mul_pd(x, y);
-        x = _mm256_add_pd(_mm256_sub_pd(x2, y2), xval);
-        y = _mm256_add_pd(_mm256_add_pd(xy, xy), yval);
-        r = _mm256_add_pd(x2, y2);
-
-        __m256i bn = _mm256_castpd_si256(cmp);
-        n = _mm256_add_epi16(n, bn);
-    }
+    auto x2 = Mul<V>(z.x, z.x);
+    auto y2 = Mul<V>(z.y, z.y);
+    auto xy = Mul<V>(z.x, z.y);
+    z.r = V::Add(x2.hi, y2.hi);
+    z.x = Add<V>(Sub<V>(x2, y2), cx);
+    z.y = Add<V>(Twice<V>(xy), cy);
+}
 
-    return n;
+bool Mandelbrot::FormulaDD::Interior(double cx, double cy)
+{
+    return Formula::Interior(cx, cy);
 }
+
+int Mandelbrot::GetDeepZoomPower() const
+{
+    return 2;
+}
+
+// Every kernel family, instantiated here where the formulas are defined
+template class FractalKernels<Mandelbrot>;
@@ -11,27 +11,52 @@
 
 #pragma once
 
-#include "Fractal.h"
+#include "FractalKernels.h"
 
-class Mandelbrot : public Fractal
+class Mandelbrot : public FractalKernels<Mandelbrot>
 {
 private:
-    int GetCPPIterF(float xval, float yval) const override;
+    friend class FractalKernels<Mandelbrot>;
 
-    int GetCPPIterD(double xval, double yval) const override;
+    // One iteration written once for every register width, every kernel family is built from it
+    struct Formula
+    {
+        template<class V>
+        static void Step(Orbit<V>& z, typename V::Reg cx, typename V::Reg cy);
+
+        static bool Interior(double cx, double cy);
+
+        template<class V>
+        static typename V::Mask InteriorMask(typename V::Reg cx, typename V::Reg cy, typename V::Mask valid);
+    };
 
-    __m128i GetSSEIterF(__m128 xval, __m128 yval) const override;
+    // Points in the main cardioid or the period-2 bulb never escape
+    // Checking analytically saves running them all the way to m_maxIterations
+    template<class T>
+    static bool InCardioidOrBulb(T xval, T yval);
 
-    __m128i GetSSEIterD(__m128d xval, __m128d yval) const override;
+    // Same test across every lane, a mask of the lanes that are inside
+    template<class V>
+    static typename V::Mask CardioidOrBulbMask(typename V::Reg xval, typename V::Reg yval);
 
-    __m256i GetAVXIterF(__m256 xval, __m256 yval) const override;
+    // The same iteration in double-double, for views too small for doubles
+    struct FormulaDD
+    {
+        template<class V>
+        static void Step(OrbitDD<V>& z, const DD<V>& cx, const DD<V>& cy);
+
+        static bool Interior(double cx, double cy);
+    };
 
-    __m256i GetAVXIterD(__m256d xval, __m256d yval) const override;
+    // Deep zooms iterate z^2 + c by perturbation
+    int GetDeepZoomPower() const override;
 
 public:
-    Mandelbrot(std::shared_ptr<App> app) : Fractal(app, -2.5, 1.5, -1.5, 1.75)
+    Mandelbrot(std::shared_ptr<App> app) : FractalKernels(app, -2.5, 1.5, -1.5, 1.75)
     {
     }
 
     ~Mandelbrot() {}
-};
\ No newline at end of file
+};
+
+extern template class FractalKernels<Mandelbrot>;
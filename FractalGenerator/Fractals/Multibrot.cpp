@@ -10,203 +10,196 @@
 **********************************************************************************************/
 
 #include "multibrot.h"
+#include "vectormath.h"
 
-int Multibrot::GetCPPIterF(float xval, float yval) const
-{
-    float x = 0.0, y = 0.0;
-    float r = 0.0;
-    int n = 0;
-
-    while (r < m_rMax && n < m_maxIterations) {
-        float x2 = x * x;
-        float x3 = x2 * x;
-        float x4 = x3 * x;
-        float x5 = x4 * x;
-
-        float y2 = y * y;
-        float y3 = y2 * y;
-        float y4 = y3 * y;
-        float y5 = y4 * y;
-
-        r = x2 + y2;
-
-        x = x5 - 10 * x3 * y2 + 5 * x * y4 + xval;
-        y = 5 * x4 * y - 10 * x2 * y3 + y5 + yval;
+#include <algorithm>
 
-        ++n;
+template<int D, class V>
+void Multibrot::Power(
+    typename V::Reg x, typename V::Reg y, typename V::Reg x2, typename V::Reg y2, typename V::Reg& px, typename V::Reg& py)
+{
+    if constexpr (D == 1)
+    {
+        px = x;
+        py = y;
+    }
+    else if constexpr (D == 2)
+    {
+        px = V::Sub(x2, y2);
+        py = V::Mul(V::Add(x, x), y);
+    }
+    else if constexpr (D % 2 == 0)
+    {
+        // (z^(D/2))^2
+        typename V::Reg hx, hy;
+        Power<D / 2, V>(x, y, x2, y2, hx, hy);
+        px = V::Sub(V::Mul(hx, hx), V::Mul(hy, hy));
+        py = V::Mul(V::Add(hx, hx), hy);
+    }
+    else
+    {
+        // z^(D-1) * z
+        typename V::Reg hx, hy;
+        Power<D - 1, V>(x, y, x2, y2, hx, hy);
+        px = V::Sub(V::Mul(hx, x), V::Mul(hy, y));
+        py = V::Fma(hx, y, V::Mul(hy, x));
     }
-
-    return n;
 }
 
-int Multibrot::GetCPPIterD(double xval, double yval) const
+template<int D, class V>
+void Multibrot::PowerDD(const DD<V>& x, const DD<V>& y, const DD<V>& x2, const DD<V>& y2, DD<V>& px, DD<V>& py)
 {
-    double x = 0.0, y = 0.0;
-    double r = 0.0;
-    int n = 0;
-
-    while (r < m_rMax && n < m_maxIterations) {
-        double x2 = x * x;
-        double x3 = x2 * x;
-        double x4 = x3 * x;
-        double x5 = x4 * x;
-
-        double y2 = y * y;
-        double y3 = y2 * y;
-        double y4 = y3 * y;
-        double y5 = y4 * y;
-
-        r = x2 + y2;
-
-        x = x5 - 10 * x3 * y2 + 5 * x * y4 + xval;
-        y = 5 * x4 * y - 10 * x2 * y3 + y5 + yval;
-
-        ++n;
+    if constexpr (D == 1)
+    {
+        px = x;
+        py = y;
+    }
+    else if constexpr (D == 2)
+    {
+        px = Sub<V>(x2, y2);
+        py = Twice<V>(Mul<V>(x, y));
+    }
+    else if constexpr (D % 2 == 0)
+    {
+        DD<V> hx, hy;
+        PowerDD<D / 2, V>(x, y, x2, y2, hx, hy);
+        px = Sub<V>(Mul<V>(hx, hx), Mul<V>(hy, hy));
+        py = Twice<V>(Mul<V>(hx, hy));
+    }
+    else
+    {
+        DD<V> hx, hy;
+        PowerDD<D - 1, V>(x, y, x2, y2, hx, hy);
+        px = Sub<V>(Mul<V>(hx, x), Mul<V>(hy, y));
+        py = Add<V>(Mul<V>(hx, y), Mul<V>(hy, x));
     }
-
-    return n;
 }
 
-__m128i Multibrot::GetSSEIterF(__m128 xval, __m128 yval) const
+template<int D>
+template<class V>
+void Multibrot::PowerFormula<D>::Step(Orbit<V>& z, typename V::Reg cx, typename V::Reg cy)
 {
-    const __m128 rMax = _mm_set1_ps(m_rMax);
-    __m128i n = _mm_setzero_si128();
-    __m128 x = _mm_setzero_ps();
-    __m128 y = _mm_setzero_ps();
-    __m128 r = _mm_setzero_ps();
-
-    for (int i = 0; i < m_maxIterations; ++i)
-    {
-        __m128 cmp = _mm_cmp_ps(rMax, r, _CMP_GT_OQ);
-        if (!_mm_movemask_ps(cmp)) break;
-
-        __m128 x2 = _mm_mul_ps(x, x);
-        __m128 x3 = _mm_mul_ps(x2, x);
-        __m128 x4 = _mm_mul_ps(x3, x);
-        __m128 x5 = _mm_mul_ps(x4, x);
-
-        __m128 y2 = _mm_mul_ps(y, y);
-        __m128 y3 = _mm_mul_ps(y2, y);
-        __m128 y4 = _mm_mul_ps(y3, y);
-        __m128 y5 = _mm_mul_ps(y4, y);
+    auto x2 = V::Mul(z.x, z.x);
+    auto y2 = V::Mul(z.y, z.y);
+    z.r = V::Add(x2, y2);
+
+    typename V::Reg px, py;
+    Power<D, V>(z.x, z.y, x2, y2, px, py);
+    z.x = V::Add(px, cx);
+    z.y = V::Add(py, cy);
+}
 
-        __m128 real1 = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(10), x3), y2); // 10x^3y^2
-        __m128 real2 = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(5), x), y4);   // 5xy^4
-        x = _mm_add_ps(_mm_add_ps(_mm_sub_ps(x5, real1), real2), xval);
+template<class V>
+void Multibrot::PolarFormula::Step(Orbit<V>& z, typename V::Reg cx, typename V::Reg cy) const
+{
+    using Scalar = typename V::Scalar;
 
-        __m128 imag1 = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(5), x4), y);
-        __m128 imag2 = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(10), x2), y3);
-        y = _mm_add_ps(_mm_add_ps(_mm_sub_ps(imag1, imag2), y5), yval);
+    auto x2 = V::Mul(z.x, z.x);
+    auto y2 = V::Mul(z.y, z.y);
+    z.r = V::Add(x2, y2);
 
-        r = _mm_add_ps(x2, y2);
+    // z^p = |z|^p (cos p theta, sin p theta), with |z|^p = e^(p/2 log |z|^2)
+    auto magnitude = Exp<V>(V::Mul(V::Set1(Scalar(exponent / 2)), Log<V>(z.r)));
+    typename V::Reg sin, cos;
+    SinCos<V>(V::Mul(V::Set1(Scalar(exponent)), Atan2<V>(z.y, z.x)), sin, cos);
 
-        __m128i bn = _mm_castps_si128(cmp);
-        n = _mm_add_epi16(n, bn);
-    }
+    // z = 0 has no log or angle, it stays at 0
+    magnitude = V::MaskMov(V::Zero(), V::CmpLt(V::Zero(), z.r), magnitude);
 
-    return n;
+    z.x = V::Fma(magnitude, cos, cx);
+    z.y = V::Fma(magnitude, sin, cy);
 }
 
-__m128i Multibrot::GetSSEIterD(__m128d xval, __m128d yval) const
+template<int D>
+template<class V>
+void Multibrot::PowerFormulaDD<D>::Step(OrbitDD<V>& z, const DD<V>& cx, const DD<V>& cy)
 {
-    const __m128d rMax = _mm_set1_pd(m_rMax);
-    __m128i n = _mm_setzero_si128();
-    __m128d x = _mm_setzero_pd();
-    __m128d y = _mm_setzero_pd();
-    __m128d abs_x = _mm_setzero_pd();
-    __m128d abs_y = _mm_setzero_pd();
-    __m128d r = _mm_setzero_pd();
+    auto x2 = Mul<V>(z.x, z.x);
+    auto y2 = Mul<V>(z.y, z.y);
+    z.r = V::Add(x2.hi, y2.hi);
+
+    DD<V> px, py;
+    PowerDD<D, V>(z.x, z.y, x2, y2, px, py);
+    z.x = Add<V>(px, cx);
+    z.y = Add<V>(py, cy);
+}
 
-    for (int i = 0; i < m_maxIterations; ++i)
+template<template<int> class Formula, class Visit>
+bool Multibrot::VisitPower(Visit&& visit) const
+{
+    switch (m_power)
     {
-        __m128d cmp = _mm_cmp_pd(rMax, r, _CMP_GT_OQ);
-        if (!_mm_movemask_pd(cmp)) break;
-
-        abs_x = _mm_andnot_pd(_mm_set1_pd(-0.0), x);
-        abs_y = _mm_andnot_pd(_mm_set1_pd(-0.0), y);
-
-        __m128d xy = _mm_mul_pd(abs_x, abs_y);
-        __m128d x2 = _mm_mul_pd(abs_x, abs_x);
-        __m128d y2 = _mm_mul_pd(abs_y, abs_y);
-        x = _mm_add_pd(_mm_sub_pd(x2, y2), xval);
-        y = _mm_add_pd(_mm_add_pd(xy, xy), yval);
-        r = _mm_add_pd(x2, y2);
-
-        __m128i bn = _mm_castpd_si128(cmp);
-        n = _mm_add_epi16(n, bn);
+    case 2:
+    {
+        visit(Formula<2>{});
+        return true;
+    }
+    case 3:
+    {
+        visit(Formula<3>{});
+        return true;
+    }
+    case 4:
+    {
+        visit(Formula<4>{});
+        return true;
+    }
+    case 5:
+    {
+        visit(Formula<5>{});
+        return true;
+    }
+    case 6:
+    {
+        visit(Formula<6>{});
+        return true;
+    }
+    case 7:
+    {
+        visit(Formula<7>{});
+        return true;
     }
+    case 8:
+    {
+        visit(Formula<8>{});
+        return true;
+    }
+    } // Switch
 
-    return n;
+    return false;
 }
 
-__m256i Multibrot::GetAVXIterF(__m256 xval, __m256 yval) const
+template<class Visit>
+void Multibrot::VisitFormula(Visit&& visit) const
 {
-    const __m256 rMax = _mm256_set1_ps(m_rMax);
-    __m256i n = _mm256_setzero_si256();
-    __m256 x = _mm256_setzero_ps();
-    __m256 y = _mm256_setzero_ps();
-    __m256 r = _mm256_setzero_ps();
-
-    for (int i = 0; i < m_maxIterations; ++i)
+    if (!VisitPower<PowerFormula>(visit))
     {
-        __m256 cmp = _mm256_cmp_ps(rMax, r, _CMP_GT_OQ);
-        if (!_mm256_movemask_ps(cmp)) break;
-
-        __m256 x2 = _mm256_mul_ps(x, x);
-        __m256 x3 = _mm256_mul_ps(x2, x);
-        __m256 x4 = _mm256_mul_ps(x3, x);
-        __m256 x5 = _mm256_mul_ps(x4, x);
-
-        __m256 y2 = _mm256_mul_ps(y, y);
-        __m256 y3 = _mm256_mul_ps(y2, y);
-        __m256 y4 = _mm256_mul_ps(y3, y);
-        __m256 y5 = _mm256_mul_ps(y4, y);
-
-        __m256 real1 = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(10), x3), y2);
-        __m256 real2 = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(5), x), y4);
-        x = _mm256_add_ps(_mm256_add_ps(_mm256_sub_ps(x5, real1), real2), xval);
-
-        __m256 imag1 = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(5), x4), y);
-        __m256 imag2 = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(10), x2), y3);
-        y = _mm256_add_ps(_mm256_add_ps(_mm256_sub_ps(imag1, imag2), y5), yval);
-
-        r = _mm256_add_ps(x2, y2);
-
-        __m256i bn = _mm256_castps_si256(cmp);
-        n = _mm256_add_epi16(n, bn);
+        visit(PolarFormula{ m_exponent });
     }
-
-    return n;
 }
 
-__m256i Multibrot::GetAVXIterD(__m256d xval, __m256d yval) const
+template<class Visit>
+bool Multibrot::VisitFormulaDD(Visit&& visit) const
 {
-    const __m256d rMax = _mm256_set1_pd(m_rMax);
-    __m256i n = _mm256_setzero_si256();
-    __m256d x = _mm256_setzero_pd();
-    __m256d y = _mm256_setzero_pd();
-    __m256d abs_x = _mm256_setzero_pd();
-    __m256d abs_y = _mm256_setzero_pd();
-    __m256d r = _mm256_setzero_pd();
-
-    for (int i = 0; i < m_maxIterations; ++i)
-    {
-        __m256d cmp = _mm256_cmp_pd(rMax, r, _CMP_GT_OQ);
-        if (!_mm256_movemask_pd(cmp)) break;
-
-        abs_x = _mm256_andnot_pd(_mm256_set1_pd(-0.0), x);
-        abs_y = _mm256_andnot_pd(_mm256_set1_pd(-0.0), y);
+    // No polar form in double-double, the other exponents stop at double precision
+    return VisitPower<PowerFormulaDD>(visit);
+}
 
-        __m256d xy = _mm256_mul_pd(abs_x, abs_y);
-        __m256d x2 = _mm256_mul_pd(abs_x, abs_x);
-        __m256d y2 = _mm256_mul_pd(abs_y, abs_y);
-        x = _mm256_add_pd(_mm256_sub_pd(x2, y2), xval);
-        y = _mm256_add_pd(_mm256_add_pd(xy, xy), yval);
-        r = _mm256_add_pd(x2, y2);
+int Multibrot::GetDeepZoomPower() const
+{
+    return m_power;
+}
 
-        __m256i bn = _mm256_castpd_si256(cmp);
-        n = _mm256_add_epi16(n, bn);
-    }
+double Multibrot::ViewExtent(double exponent)
+{
+    return std::max(1.5, 1.25 * std::pow(2.0, 1.0 / (exponent - 1.0)));
+}
 
-    return n;
+int Multibrot::WholePower(double exponent)
+{
+    int power = static_cast<int>(exponent);
+    return power == exponent && power >= 2 && power <= 8 ? power : 0;
 }
+
+// Every kernel family, instantiated here where the formulas are defined
+template class FractalKernels<Multibrot>;
@@ -11,27 +11,91 @@
 
 #pragma once
 
-#include "Fractal.h"
+#include "FractalKernels.h"
 
-class Multibrot : public Fractal
+class Multibrot : public FractalKernels<Multibrot>
 {
 private:
-    int GetCPPIterF(float xval, float yval) const override;
+    friend class FractalKernels<Multibrot>;
 
-    int GetCPPIterD(double xval, double yval) const override;
+    // z^D + c for a whole power, by squaring and multiplying, every kernel family is built from it
+    template<int D>
+    struct PowerFormula
+    {
+        template<class V>
+        static void Step(Orbit<V>& z, typename V::Reg cx, typename V::Reg cy);
+    };
+
+    // z^p + c for any power, through the polar form
+    struct PolarFormula
+    {
+        double exponent;
+
+        template<class V>
+        void Step(Orbit<V>& z, typename V::Reg cx, typename V::Reg cy) const;
+    };
+
+    // The same whole powers in double-double, for views too small for doubles
+    template<int D>
+    struct PowerFormulaDD
+    {
+        template<class V>
+        static void Step(OrbitDD<V>& z, const DD<V>& cx, const DD<V>& cy);
+    };
 
-    __m128i GetSSEIterF(__m128 xval, __m128 yval) const override;
+    // z^D, given the squares of x and y (the escape test needs them anyway)
+    template<int D, class V>
+    static void Power(
+        typename V::Reg x,
+        typename V::Reg y,
+        typename V::Reg x2,
+        typename V::Reg y2,
+        typename V::Reg& px,
+        typename V::Reg& py);
 
-    __m128i GetSSEIterD(__m128d xval, __m128d yval) const override;
+    template<int D, class V>
+    static void PowerDD(
+        const DD<V>& x,
+        const DD<V>& y,
+        const DD<V>& x2,
+        const DD<V>& y2,
+        DD<V>& px,
+        DD<V>& py);
 
-    __m256i GetAVXIterF(__m256 xval, __m256 yval) const override;
+    // Whole powers 2 to 8 each have their own formula, picked from m_power
+    // False for the other exponents
+    template<template<int> class Formula, class Visit>
+    bool VisitPower(
+        Visit&& visit) const;
 
-    __m256i GetAVXIterD(__m256d xval, __m256d yval) const override;
+    template<class Visit>
+    void VisitFormula(
+        Visit&& visit) const;
+
+    template<class Visit>
+    bool VisitFormulaDD(
+        Visit&& visit) const;
+
+    // Deep zooms iterate z^d + c by perturbation, only for whole powers
+    int GetDeepZoomPower() const override;
+
+    // Half the height of the starting view, the set lies within |c| <= 2^(1 / (p - 1))
+    static double ViewExtent(double exponent);
+
+    // The exponent as a whole power 2 to 8, 0 when it isn't one
+    static int WholePower(double exponent);
+
+    double m_exponent;
+    int m_power;
 
 public:
-    Multibrot(std::shared_ptr<App> app) : Fractal(app, -1.5, 1.5, -1.5, 1.75)
+    Multibrot(std::shared_ptr<App> app, double exponent)
+        : FractalKernels(app, -ViewExtent(exponent), ViewExtent(exponent), -ViewExtent(exponent), ViewExtent(exponent) * 7 / 6),
+        m_exponent(exponent), m_power(WholePower(exponent))
     {
     }
 
     ~Multibrot() {}
 };
+
+extern template class FractalKernels<Multibrot>;
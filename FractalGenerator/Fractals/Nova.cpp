@@ -11,96 +11,36 @@
 
 #include "nova.h"
 
-int Nova::GetCPPIterF(float xval, float yval) const
+template<class V>
+void Nova::Formula::Step(Orbit<V>& z, typename V::Reg cx, typename V::Reg cy)
 {
-    float x = 0.0, y = 0.0;
-    float r = 0.0;
-    int n = 0;
-
-    while (r < m_rMax && n < m_maxIterations) {
-        float x2 = x * x;
-        float x3 = x2 * x;
-        float y2 = y * y;
-        float y3 = y2 * y;
-
-        float fx = x3 - 3 * x * y2 - 1.0f;
-        float fy = 3 * x2 * y - y3;
-        float fPx = 3.0f * (x2 - y2);
-        float fPy = 6.0f * x * y;
-
-        float denominator = fPx * fPx + fPy * fPy;
-        float divx = 0.0f, divy = 0.0f;
-
-        if (denominator > 1e-12f)
-        {
-            divx = (fx * fPx + fy * fPy) / denominator;
-            divy = (fPx * fy - fx * fPy) / denominator;
-        }
-
-        r = x2 + y2;
-
-        x = x - m_rMax * divx + xval;
-        y = y - m_rMax * divy + yval;
-
-        ++n;
-    }
-
-    return n;
-}
-
-int Nova::GetCPPIterD(double xval, double yval) const
-{
-    double x = 0.0, y = 0.0;
-    double r = 0.0;
-    int n = 0;
-
-    while (r < m_rMax && n < m_maxIterations) {
-        double x2 = x * x;
-        double x3 = x2 * x;
-        double y2 = y * y;
-        double y3 = y2 * y;
-
-        double fx = x3 - 3 * x * y2 - 1.0;
-        double fy = 3 * x2 * y - y3;
-        double fPx = 3.0 * (x2 - y2);
-        double fPy = 6.0 * x * y;
-
-        double denominator = fPx * fPx + fPy * fPy;
-        double divx = 0.0, divy = 0.0;
-
-        if (denominator > 1e-12)
-        {
-            divx = (fx * fPx + fy * fPy) / denominator;
-            divy = (fPx * fy - fx * fPy) / denominator;
-        }
-
-        r = x2 + y2;
-
-        x = x - m_rMax * divx + xval;
-        y = y - m_rMax * divy + yval;
-
-        ++n;
-    }
-
-    return n;
+    using Scalar = typename V::Scalar;
+
+    // The Newton step is relaxed by the escape radius, as it always has been
+    const auto relaxation = V::Set1(Scalar(4));
+    const auto three = V::Set1(Scalar(3));
+
+    auto x = z.x, y = z.y;
+    auto x2 = V::Mul(x, x);
+    auto y2 = V::Mul(y, y);
+
+    // f(z) = z^3 - 1 and f'(z) = 3z^2
+    auto fx = V::Sub(V::Mul(x, V::Sub(x2, V::Mul(three, y2))), V::Set1(Scalar(1)));
+    auto fy = V::Mul(y, V::Sub(V::Mul(three, x2), y2));
+    auto fPx = V::Mul(three, V::Sub(x2, y2));
+    auto fPy = V::Mul(V::Set1(Scalar(6)), V::Mul(x, y));
+
+    // f / f' with one divide, lanes with a vanishing derivative get next to nothing and are masked to 0
+    auto denominator = V::Fma(fPx, fPx, V::Mul(fPy, fPy));
+    auto step = V::CmpLt(V::Set1(Scalar(1e-12)), denominator);
+    auto inverse = V::MaskMov(V::Zero(), step, V::Div(V::Set1(Scalar(1)), denominator));
+    auto divx = V::Mul(V::Fma(fx, fPx, V::Mul(fy, fPy)), inverse);
+    auto divy = V::Mul(V::Sub(V::Mul(fPx, fy), V::Mul(fx, fPy)), inverse);
+
+    z.r = V::Add(x2, y2);
+    z.x = V::Add(V::Sub(x, V::Mul(relaxation, divx)), cx);
+    z.y = V::Add(V::Sub(y, V::Mul(relaxation, divy)), cy);
 }
 
-__m128i Nova::GetSSEIterF(__m128 xval, __m128 yval) const
-{
-    return _mm_setzero_si128();
-}
-
-__m128i Nova::GetSSEIterD(__m128d xval, __m128d yval) const
-{
-    return _mm_setzero_si128();
-}
-
-__m256i Nova::GetAVXIterF(__m256 xval, __m256 yval) const
-{
-    return _mm256_setzero_si256();
-}
-
-__m256i Nova::GetAVXIterD(__m256d xval, __m256d yval) const
-{
-    return _mm256_setzero_si256();
-}
+// Every kernel family, instantiated here where the formula is defined
+template class FractalKernels<Nova>;
@@ -11,27 +11,27 @@
 
 #pragma once
 
-#include "Fractal.h"
+#include "FractalKernels.h"
 
-class Nova : public Fractal
+class Nova : public FractalKernels<Nova>
 {
 private:
-    int GetCPPIterF(float xval, float yval) const override;
+    friend class FractalKernels<Nova>;
 
-    int GetCPPIterD(double xval, double yval) const override;
-
-    __m128i GetSSEIterF(__m128 xval, __m128 yval) const override;
-
-    __m128i GetSSEIterD(__m128d xval, __m128d yval) const override;
-
-    __m256i GetAVXIterF(__m256 xval, __m256 yval) const override;
-
-    __m256i GetAVXIterD(__m256d xval, __m256d yval) const override;
+    // One Newton step of z^3 - 1 plus c
+    // Lanes where the derivative vanishes take no Newton step, the divide is masked off
+    struct Formula
+    {
+        template<class V>
+        static void Step(Orbit<V>& z, typename V::Reg cx, typename V::Reg cy);
+    };
 
 public:
-    Nova(std::shared_ptr<App> app) : Fractal(app, -2.5, 2.5, -2.5, 2.75)
+    Nova(std::shared_ptr<App> app) : FractalKernels(app, -2.5, 2.5, -2.5, 2.75)
     {
     }
 
     ~Nova() {}
 };
+
+extern template class FractalKernels<Nova>;
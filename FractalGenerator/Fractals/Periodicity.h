@@ -0,0 +1,74 @@
+/*********************************************************************************************
+**
+**	File Name:		periodicity.h
+**	Description:	This is the header file that contains Brent style cycle detection for the
+**                  escape time kernels, so orbits that settle into a cycle stop early
+**
+**	Author:			Clarke Needles
+**	Created:		10/17/2026
+**
+**********************************************************************************************/
+
+#pragma once
+
+#include "Simd.h"
+
+// An orbit is compared against a saved reference point after every iteration
+// The reference is moved up to the current point after intervals of 1, 2, 4, 8... iterations
+// (after iterations 1, 3, 7, 15...), so any cycle shorter than the current interval gets caught
+// once the orbit has settled on it. The streaming kernels follow the same schedule lane by lane,
+// so they retire the same pixels as the block kernels
+
+// One orbit per lane (one lane for the C++ kernels)
+// Every lane starts on the same iteration, so they can all share one schedule
+// SecondOrder (IsSecondOrder<Formula>) compares xprev/yprev as well
+template<class V, bool SecondOrder = false>
+class VectorPeriodCheck
+{
+private:
+    using Reg = typename V::Reg;
+    using Mask = typename V::Mask;
+
+    Reg m_xRef = V::Zero(), m_yRef = V::Zero();
+    Reg m_xprevRef = V::Zero(), m_yprevRef = V::Zero(); // Only followed for second order formulas
+    Reg m_tolerance;
+    int m_interval = 1;
+    int m_steps = 0;
+
+private:
+    Mask Near(Reg a, Reg ref) const
+    {
+        return V::CmpLe(V::Abs(V::Sub(a, ref)), m_tolerance);
+    }
+
+public:
+    explicit VectorPeriodCheck(typename V::Scalar tolerance) : m_tolerance(V::Set1(tolerance))
+    {
+    }
+
+    // Call with every new point of the orbits, returns a mask of the lanes that have come back around
+    // Second order orbits also have to be back at the reference's previous point
+    Mask Update(const Orbit<V>& z)
+    {
+        Mask hit = V::And(Near(z.x, m_xRef), Near(z.y, m_yRef));
+        if constexpr (SecondOrder)
+        {
+            hit = V::And(hit, V::And(Near(z.xprev, m_xprevRef), Near(z.yprev, m_yprevRef)));
+        }
+
+        if (++m_steps == m_interval)
+        {
+            m_steps = 0;
+            m_interval *= 2;
+            m_xRef = z.x;
+            m_yRef = z.y;
+            if constexpr (SecondOrder)
+            {
+                m_xprevRef = z.xprev;
+                m_yprevRef = z.yprev;
+            }
+        }
+
+        return hit;
+    }
+};
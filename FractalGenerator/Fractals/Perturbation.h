@@ -0,0 +1,271 @@
+/*********************************************************************************************
+**
+**	File Name:		perturbation.h
+**	Description:	This is the header file that contains the perturbation (deep zoom) kernels.
+**                  Pixels iterate their offset from one high precision reference orbit in
+**                  plain doubles
+**
+**	Author:			Clarke Needles
+**	Created:		10/17/2026
+**
+**********************************************************************************************/
+
+#pragma once
+
+#include <vector>
+#include "Simd.h"
+
+// For z -> z^d + c, with the reference orbit Z and a pixel's offset dz (z = Z + dz):
+//   dz -> (Z + dz)^d - Z^d + dc = dz * (a_1 + a_2 dz + ... + a_d dz^(d-1)) + dc
+// where a_k = C(d, k) Z^(d-k). Only the small offsets are iterated, so doubles are enough no
+// matter how deep the view is.
+
+// Reference orbit, computed in high precision then rounded to doubles
+struct ReferenceOrbit
+{
+    int power = 2;
+    int length = 0;
+
+    // Z_n, n = 0 .. length - 1
+    std::vector<double> x, y;
+
+    // a_k for k = 1 .. power - 1 (a_power is always 1), stored coefficient by coefficient
+    // a_k of Z_n is at [(k - 1) * length + n] so the vector kernels can gather them
+    std::vector<double> coefX, coefY;
+
+    // Series approximation, every pixel starts at iteration skip with
+    //   dz = B_1 u + B_2 u^2 + ... + B_T u^T, u = dc / seriesRadius
+    // B_j is kept scaled by seriesRadius^j so deep zooms don't underflow (index j - 1)
+    int skip = 0;
+    double seriesRadius = 1;
+    std::vector<double> seriesX, seriesY;
+};
+
+// A list of pixels for the perturbation kernels to compute
+struct PerturbJob
+{
+    const int* pixels;  // Pixel indices (y * width + x)
+    int numPixels;
+    int width;
+
+    // Offset of pixel 0 from the reference point and the size of a pixel
+    double dcx, dcy;
+    double dx, dy;
+
+    const ReferenceOrbit* reference;
+
+    int* iterations;    // Output, one per entry in pixels (-1 = glitched, needs another reference)
+};
+
+// Orbits that land this close to zero relative to the reference have lost their precision
+// (Pauldelbrot's test, on |z|^2 / |Z|^2)
+constexpr double g_glitchTolerance = 1e-6;
+
+// Offset from the reference at iteration ref.skip for a pixel dc away from it
+inline void SeriesStart(const ReferenceOrbit& ref, double dcx, double dcy, double& dzx, double& dzy)
+{
+    const double ux = dcx / ref.seriesRadius, uy = dcy / ref.seriesRadius;
+
+    // p = B_1 + u (B_2 + u (... + u B_T)), then dz = u * p
+    double px = 0, py = 0;
+    for (int j = static_cast<int>(ref.seriesX.size()) - 1; j >= 0; --j)
+    {
+        double tx = px * ux - py * uy + ref.seriesX[j];
+        py = px * uy + py * ux + ref.seriesY[j];
+        px = tx;
+    }
+
+    dzx = px * ux - py * uy;
+    dzy = px * uy + py * ux;
+}
+
+// One pixel at a time
+inline void PerturbScalar(const PerturbJob& job, int maxIterations, double rMax)
+{
+    const ReferenceOrbit& ref = *job.reference;
+
+    for (int i = 0; i < job.numPixels; ++i)
+    {
+        const double dcx = job.dcx + (job.pixels[i] % job.width) * job.dx;
+        const double dcy = job.dcy + (job.pixels[i] / job.width) * job.dy;
+
+        // The series takes every pixel straight to ref.skip
+        double dzx, dzy;
+        SeriesStart(ref, dcx, dcy, dzx, dzy);
+        int m = ref.skip; // Where we are in the reference
+        int n = ref.skip;
+        int result = maxIterations;
+
+        for (; n < maxIterations; ++n)
+        {
+            double zx = ref.x[m] + dzx;
+            double zy = ref.y[m] + dzy;
+            double r = zx * zx + zy * zy;
+            if (r >= rMax)
+            {
+                result = n + 1;
+                break;
+            }
+
+            // Rebase (Zhuoran): once the full orbit is smaller than the offset, carry on from
+            // the full value against the start of the reference, also when the reference runs out
+            if (r < dzx * dzx + dzy * dzy || m == ref.length - 1)
+            {
+                // Pauldelbrot: z cancelled down to almost nothing, its digits can't be trusted
+                if (r < g_glitchTolerance * (ref.x[m] * ref.x[m] + ref.y[m] * ref.y[m]))
+                {
+                    result = -1;
+                    break;
+                }
+
+                dzx = zx;
+                dzy = zy;
+                m = 0;
+            }
+
+            // p = a_1 + dz (a_2 + dz (... + dz)), then dz = dz * p + dc
+            double px = 1, py = 0;
+            for (int k = ref.power - 1; k >= 1; --k)
+            {
+                double tx = px * dzx - py * dzy + ref.coefX[(k - 1) * ref.length + m];
+                py = px * dzy + py * dzx + ref.coefY[(k - 1) * ref.length + m];
+                px = tx;
+            }
+
+            double tx = dzx * px - dzy * py + dcx;
+            dzy = dzx * py + dzy * px + dcy;
+            dzx = tx;
+            ++m;
+        }
+
+        job.iterations[i] = result;
+    }
+}
+
+// Lane refill version, every lane is at its own place in the reference after a rebase so the
+// reference is gathered
+template<class V>
+void PerturbKernel(const PerturbJob& job, int maxIterations, double rMax)
+{
+    using Reg = typename V::Reg;
+    using Scalar = typename V::Scalar;
+    constexpr int L = V::Lanes;
+
+    const ReferenceOrbit& ref = *job.reference;
+    if (job.numPixels <= 0) return;
+
+    // Per lane bookkeeping, only touched when a lane is refilled
+    alignas(64) Scalar dcxLane[L], dcyLane[L], dzxLane[L], dzyLane[L], nLane[L], mLane[L], validLane[L];
+    int slot[L];
+
+    const Scalar allSet = [] { Scalar s; memset(&s, 0xFF, sizeof(s)); return s; }();
+    int next = 0;
+
+    auto refill = [&](int lane)
+    {
+        if (next < job.numPixels)
+        {
+            int pixel = job.pixels[next];
+            double dzx, dzy;
+            dcxLane[lane] = job.dcx + (pixel % job.width) * job.dx;
+            dcyLane[lane] = job.dcy + (pixel / job.width) * job.dy;
+            SeriesStart(ref, dcxLane[lane], dcyLane[lane], dzx, dzy);
+            dzxLane[lane] = dzx;
+            dzyLane[lane] = dzy;
+            nLane[lane] = mLane[lane] = static_cast<Scalar>(ref.skip);
+            validLane[lane] = allSet;
+            slot[lane] = next++;
+        }
+        else
+        {
+            dzxLane[lane] = dzyLane[lane] = nLane[lane] = mLane[lane] = 0;
+            dcxLane[lane] = dcyLane[lane] = 0;
+            validLane[lane] = 0;
+            slot[lane] = -1;
+        }
+    };
+
+    for (int lane = 0; lane < L; ++lane)
+    {
+        refill(lane);
+    }
+
+    const Reg vrMax = V::Set1(rMax);
+    const Reg vMaxIter = V::Set1(static_cast<Scalar>(maxIterations));
+    const Reg vLast = V::Set1(static_cast<Scalar>(ref.length - 1));
+    const Reg vGlitch = V::Set1(g_glitchTolerance);
+    const Reg one = V::Set1(1);
+
+    Reg dcx = V::Load(dcxLane), dcy = V::Load(dcyLane);
+    Reg dzx = V::Load(dzxLane), dzy = V::Load(dzyLane);
+    Reg n = V::Load(nLane), m = V::Load(mLane);
+    Reg valid = V::Load(validLane);
+
+    while (true)
+    {
+        Reg Zx = V::Gather(ref.x.data(), m);
+        Reg Zy = V::Gather(ref.y.data(), m);
+        Reg zx = V::Add(Zx, dzx);
+        Reg zy = V::Add(Zy, dzy);
+        Reg r = V::Add(V::Mul(zx, zx), V::Mul(zy, zy));
+
+        Reg escaped = V::CmpLe(vrMax, r);
+        Reg finished = V::CmpLe(vMaxIter, n);
+        Reg rebase = V::Or(V::CmpLt(r, V::Add(V::Mul(dzx, dzx), V::Mul(dzy, dzy))), V::CmpEq(m, vLast));
+        Reg glitch = V::And(rebase, V::CmpLt(r, V::Mul(vGlitch, V::Add(V::Mul(Zx, Zx), V::Mul(Zy, Zy)))));
+
+        int done = V::MoveMask(V::And(valid, V::Or(V::Or(escaped, finished), glitch)));
+        if (done)
+        {
+            // Write back the finished lanes and start them on new pixels
+            alignas(64) Scalar escapedLane[L], finishedLane[L];
+            V::Store(nLane, n); V::Store(mLane, m);
+            V::Store(dzxLane, dzx); V::Store(dzyLane, dzy);
+            V::Store(escapedLane, escaped); V::Store(finishedLane, finished);
+
+            for (int lane = 0; lane < L; ++lane)
+            {
+                if (done & (1 << lane))
+                {
+                    int count = static_cast<int>(nLane[lane]);
+                    job.iterations[slot[lane]] = finishedLane[lane] != 0 ? maxIterations : escapedLane[lane] != 0 ? count + 1 : -1;
+                    refill(lane);
+                }
+            }
+
+            n = V::Load(nLane); m = V::Load(mLane);
+            dzx = V::Load(dzxLane); dzy = V::Load(dzyLane);
+            dcx = V::Load(dcxLane); dcy = V::Load(dcyLane);
+            valid = V::Load(validLane);
+
+            if (!V::MoveMask(valid)) break;
+
+            // The new lanes need their z worked out from the start
+            continue;
+        }
+
+        // Rebasing lanes carry on from z against Z_0
+        dzx = V::Blend(rebase, zx, dzx);
+        dzy = V::Blend(rebase, zy, dzy);
+        m = V::AndNot(rebase, m);
+
+        // p = a_1 + dz (a_2 + dz (... + dz)), then dz = dz * p + dc
+        Reg px = one, py = V::Zero();
+        for (int k = ref.power - 1; k >= 1; --k)
+        {
+            Reg ax = V::Gather(ref.coefX.data() + (k - 1) * ref.length, m);
+            Reg ay = V::Gather(ref.coefY.data() + (k - 1) * ref.length, m);
+            Reg tx = V::Add(V::Sub(V::Mul(px, dzx), V::Mul(py, dzy)), ax);
+            py = V::Add(V::Add(V::Mul(px, dzy), V::Mul(py, dzx)), ay);
+            px = tx;
+        }
+
+        Reg tx = V::Add(V::Sub(V::Mul(dzx, px), V::Mul(dzy, py)), dcx);
+        dzy = V::Add(V::Add(V::Mul(dzx, py), V::Mul(dzy, px)), dcy);
+        dzx = tx;
+
+        // Parked lanes stay at 0 so their gathers stay inside the reference
+        n = V::Add(n, V::And(valid, one));
+        m = V::Add(m, V::And(valid, one));
+    }
+}
@@ -11,27 +11,38 @@
 
 #pragma once
 
-#include "Fractal.h"
+#include "FractalKernels.h"
 
-class Pheonix : public Fractal
+class Pheonix : public FractalKernels<Pheonix>
 {
 private:
-    int GetCPPIterF(float xval, float yval) const override;
+    friend class FractalKernels<Pheonix>;
 
-    int GetCPPIterD(double xval, double yval) const override;
-
-    __m128i GetSSEIterF(__m128 xval, __m128 yval) const override;
+    // One iteration written once for every register width, every kernel family is built from it
+    struct Formula
+    {
+        // The next point takes in the previous one, cycle detection has to match both
+        static constexpr bool SecondOrder = true;
 
-    __m128i GetSSEIterD(__m128d xval, __m128d yval) const override;
+        template<class V>
+        static void Step(Orbit<V>& z, typename V::Reg cx, typename V::Reg cy);
+    };
 
-    __m256i GetAVXIterF(__m256 xval, __m256 yval) const override;
+    // The same iteration in double-double, for views too small for doubles
+    struct FormulaDD
+    {
+        static constexpr bool SecondOrder = true;
 
-    __m256i GetAVXIterD(__m256d xval, __m256d yval) const override;
+        template<class V>
+        static void Step(OrbitDD<V>& z, const DD<V>& cx, const DD<V>& cy);
+    };
 
 public:
-    Pheonix(std::shared_ptr<App> app) : Fractal(app, -2.0, 1.0, -1.5, 1.75)
+    Pheonix(std::shared_ptr<App> app) : FractalKernels(app, -2.0, 1.0, -1.5, 1.75)
     {
     }
 
     ~Pheonix() {}
 };
+
+extern template class FractalKernels<Pheonix>;
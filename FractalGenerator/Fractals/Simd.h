@@ -0,0 +1,668 @@
+/*********************************************************************************************
+**
+**	File Name:		simd.h
+**	Description:	This is the header file that contains thin wrappers around the SSE and
+**                  AVX registers, so a fractal step can be written once for every width,
+**                  and the streaming (lane refill) kernel built on top of them
+**
+**	Author:			Clarke Needles
+**	Created:		10/17/2026
+**
+**********************************************************************************************/
+
+#pragma once
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <immintrin.h>
+#include <emmintrin.h>
+
+// Masks are kept in the float registers (all bits set = true) like _mm_cmp_ps returns them
+// Every wrapper has a Mask type and MaskAdd/MaskMov, so a kernel can be written once for these,
+// the C++ wrappers (a bool) and the AVX-512 ones (a mask register)
+
+// One float or double for the C++ kernels, the mask is a plain bool
+template<class T>
+struct Cpp
+{
+    using Reg = T;
+    using Scalar = T;
+    using Mask = bool;
+    static constexpr int Lanes = 1;
+
+    static Reg Set1(Scalar a) { return a; }
+    static Reg Zero() { return 0; }
+    static Reg Load(const Scalar* p) { return *p; }
+    static void Store(Scalar* p, Reg a) { *p = a; }
+    static Reg Add(Reg a, Reg b) { return a + b; }
+    static Reg Sub(Reg a, Reg b) { return a - b; }
+    static Reg Mul(Reg a, Reg b) { return a * b; }
+    static Reg Div(Reg a, Reg b) { return a / b; }
+    static Reg Fma(Reg a, Reg b, Reg c) { return a * b + c; }
+    static Reg Abs(Reg a) { return std::fabs(a); }
+    static Mask CmpLt(Reg a, Reg b) { return a < b; }
+    static Mask CmpLe(Reg a, Reg b) { return a <= b; }
+    static Mask CmpEq(Reg a, Reg b) { return a == b; }
+    static Mask And(Mask a, Mask b) { return a && b; }
+    static Mask Or(Mask a, Mask b) { return a || b; }
+    static Mask AndNot(Mask a, Mask b) { return !a && b; }
+    static Reg Blend(Mask mask, Reg a, Reg b) { return mask ? a : b; }
+    static Reg MaskAdd(Reg src, Mask k, Reg a, Reg b) { return k ? a + b : src; }
+    static Reg MaskMov(Reg src, Mask k, Reg a) { return k ? a : src; }
+    static int MoveMask(Mask a) { return a; }
+};
+
+using CppF = Cpp<float>;
+using CppD = Cpp<double>;
+
+// One double with the mask kept in a double (all bits set), for the double-double kernel which
+// stores its masks alongside the values
+struct ScalarD
+{
+    using Reg = double;
+    using Scalar = double;
+    using Mask = Reg;
+    static constexpr int Lanes = 1;
+
+    static Reg FromBits(uint64_t a) { return std::bit_cast<double>(a); }
+    static uint64_t ToBits(Reg a) { return std::bit_cast<uint64_t>(a); }
+    static Reg FromBool(bool a) { return FromBits(a ? ~uint64_t(0) : 0); }
+
+    static Reg Set1(Scalar a) { return a; }
+    static Reg Zero() { return 0.0; }
+    static Reg Load(const Scalar* p) { return *p; }
+    static void Store(Scalar* p, Reg a) { *p = a; }
+    static Reg Add(Reg a, Reg b) { return a + b; }
+    static Reg Sub(Reg a, Reg b) { return a - b; }
+    static Reg Mul(Reg a, Reg b) { return a * b; }
+    static Reg Fma(Reg a, Reg b, Reg c) { return a * b + c; }
+    static Reg Fms(Reg a, Reg b, Reg c) { return std::fma(a, b, -c); }
+    static Reg Abs(Reg a) { return std::fabs(a); }
+    static Reg CmpLt(Reg a, Reg b) { return FromBool(a < b); }
+    static Reg CmpLe(Reg a, Reg b) { return FromBool(a <= b); }
+    static Reg CmpEq(Reg a, Reg b) { return FromBool(a == b); }
+    static Reg And(Reg a, Reg b) { return FromBits(ToBits(a) & ToBits(b)); }
+    static Reg Or(Reg a, Reg b) { return FromBits(ToBits(a) | ToBits(b)); }
+    static Reg AndNot(Reg a, Reg b) { return FromBits(~ToBits(a) & ToBits(b)); }
+    static Reg Blend(Reg mask, Reg a, Reg b) { return ToBits(mask) ? a : b; }
+    static Reg MaskAdd(Reg src, Mask k, Reg a, Reg b) { return ToBits(k) ? a + b : src; }
+    static Reg MaskMov(Reg src, Mask k, Reg a) { return ToBits(k) ? a : src; }
+    static int MoveMask(Reg a) { return static_cast<int>(ToBits(a) >> 63); }
+};
+
+// SSE, 4 floats
+struct SseF
+{
+    using Reg = __m128;
+    using Mask = Reg;
+    using Scalar = float;
+    static constexpr int Lanes = 4;
+
+    static Reg Set1(Scalar a) { return _mm_set1_ps(a); }
+    static Reg Zero() { return _mm_setzero_ps(); }
+    static Reg Load(const Scalar* p) { return _mm_loadu_ps(p); }
+    static void Store(Scalar* p, Reg a) { _mm_storeu_ps(p, a); }
+    static Reg Add(Reg a, Reg b) { return _mm_add_ps(a, b); }
+    static Reg Sub(Reg a, Reg b) { return _mm_sub_ps(a, b); }
+    static Reg Mul(Reg a, Reg b) { return _mm_mul_ps(a, b); }
+    static Reg Div(Reg a, Reg b) { return _mm_div_ps(a, b); }
+    static Reg Min(Reg a, Reg b) { return _mm_min_ps(a, b); }
+    static Reg Max(Reg a, Reg b) { return _mm_max_ps(a, b); }
+    static Reg Floor(Reg a) { return _mm_floor_ps(a); }
+    static Reg Fma(Reg a, Reg b, Reg c) { return _mm_add_ps(_mm_mul_ps(a, b), c); } // a * b + c, SSE4.1 has no FMA
+    static Reg Abs(Reg a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); } // Clearing the sign bit
+    static Reg CmpLt(Reg a, Reg b) { return _mm_cmplt_ps(a, b); }
+    static Reg CmpLe(Reg a, Reg b) { return _mm_cmple_ps(a, b); }
+    static Reg CmpEq(Reg a, Reg b) { return _mm_cmpeq_ps(a, b); }
+    static Reg And(Reg a, Reg b) { return _mm_and_ps(a, b); }
+    static Reg Or(Reg a, Reg b) { return _mm_or_ps(a, b); }
+    static Reg AndNot(Reg a, Reg b) { return _mm_andnot_ps(a, b); } // ~a & b
+    static Reg Blend(Reg mask, Reg a, Reg b) { return _mm_blendv_ps(b, a, mask); } // mask ? a : b
+    static Reg MaskAdd(Reg src, Mask k, Reg a, Reg b) { return _mm_blendv_ps(src, _mm_add_ps(a, b), k); }
+    static Reg MaskMov(Reg src, Mask k, Reg a) { return _mm_blendv_ps(src, a, k); }
+    static int MoveMask(Reg a) { return _mm_movemask_ps(a); }
+
+    // A positive normal float as Mantissa(a) * 2^Exponent(a), with the mantissa in [1, 2), and 2^n
+    // for a whole n back again, worked on the bits
+    static Reg Exponent(Reg a) { return _mm_sub_ps(_mm_cvtepi32_ps(_mm_srli_epi32(_mm_castps_si128(a), 23)), _mm_set1_ps(127.0f)); }
+    static Reg Mantissa(Reg a) { return _mm_or_ps(_mm_and_ps(a, _mm_castsi128_ps(_mm_set1_epi32(0x007FFFFF))), _mm_set1_ps(1.0f)); }
+    static Reg Pow2(Reg n) { return _mm_castsi128_ps(_mm_slli_epi32(_mm_castps_si128(_mm_add_ps(n, _mm_set1_ps(8388608.0f + 127.0f))), 23)); }
+};
+
+// SSE, 2 doubles
+struct SseD
+{
+    using Reg = __m128d;
+    using Mask = Reg;
+    using Scalar = double;
+    static constexpr int Lanes = 2;
+
+    static Reg Set1(Scalar a) { return _mm_set1_pd(a); }
+    static Reg Zero() { return _mm_setzero_pd(); }
+    static Reg Load(const Scalar* p) { return _mm_loadu_pd(p); }
+    static void Store(Scalar* p, Reg a) { _mm_storeu_pd(p, a); }
+    static Reg Add(Reg a, Reg b) { return _mm_add_pd(a, b); }
+    static Reg Sub(Reg a, Reg b) { return _mm_sub_pd(a, b); }
+    static Reg Mul(Reg a, Reg b) { return _mm_mul_pd(a, b); }
+    static Reg Div(Reg a, Reg b) { return _mm_div_pd(a, b); }
+    static Reg Min(Reg a, Reg b) { return _mm_min_pd(a, b); }
+    static Reg Max(Reg a, Reg b) { return _mm_max_pd(a, b); }
+    static Reg Floor(Reg a) { return _mm_floor_pd(a); }
+    static Reg Fma(Reg a, Reg b, Reg c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+    static Reg Abs(Reg a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+    static Reg CmpLt(Reg a, Reg b) { return _mm_cmplt_pd(a, b); }
+    static Reg CmpLe(Reg a, Reg b) { return _mm_cmple_pd(a, b); }
+    static Reg CmpEq(Reg a, Reg b) { return _mm_cmpeq_pd(a, b); }
+    static Reg And(Reg a, Reg b) { return _mm_and_pd(a, b); }
+    static Reg Or(Reg a, Reg b) { return _mm_or_pd(a, b); }
+    static Reg AndNot(Reg a, Reg b) { return _mm_andnot_pd(a, b); }
+    static Reg Blend(Reg mask, Reg a, Reg b) { return _mm_blendv_pd(b, a, mask); }
+    static Reg MaskAdd(Reg src, Mask k, Reg a, Reg b) { return _mm_blendv_pd(src, _mm_add_pd(a, b), k); }
+    static Reg MaskMov(Reg src, Mask k, Reg a) { return _mm_blendv_pd(src, a, k); }
+    static Reg Gather(const Scalar* p, Reg index) // p[index] per lane, two loads since gathers need AVX2
+    {
+        __m128i i = _mm_cvttpd_epi32(index);
+        return _mm_set_pd(p[_mm_extract_epi32(i, 1)], p[_mm_cvtsi128_si32(i)]);
+    }
+    static int MoveMask(Reg a) { return _mm_movemask_pd(a); }
+
+    // No 64 bit integer conversions before AVX-512, adding 2^52 lines a whole number up with the
+    // low bits of the double instead
+    static Reg Exponent(Reg a)
+    {
+        const __m128d magic = _mm_set1_pd(4503599627370496.0); // 2^52
+        return _mm_sub_pd(_mm_or_pd(_mm_castsi128_pd(_mm_srli_epi64(_mm_castpd_si128(a), 52)), magic), _mm_set1_pd(4503599627370496.0 + 1023.0));
+    }
+    static Reg Mantissa(Reg a) { return _mm_or_pd(_mm_and_pd(a, _mm_castsi128_pd(_mm_set1_epi64x(0x000FFFFFFFFFFFFF))), _mm_set1_pd(1.0)); }
+    static Reg Pow2(Reg n) { return _mm_castsi128_pd(_mm_slli_epi64(_mm_castpd_si128(_mm_add_pd(n, _mm_set1_pd(4503599627370496.0 + 1023.0))), 52)); }
+};
+
+// AVX, 8 floats
+struct AvxF
+{
+    using Reg = __m256;
+    using Mask = Reg;
+    using Scalar = float;
+    static constexpr int Lanes = 8;
+
+    static Reg Set1(Scalar a) { return _mm256_set1_ps(a); }
+    static Reg Zero() { return _mm256_setzero_ps(); }
+    static Reg Load(const Scalar* p) { return _mm256_loadu_ps(p); }
+    static void Store(Scalar* p, Reg a) { _mm256_storeu_ps(p, a); }
+    static Reg Add(Reg a, Reg b) { return _mm256_add_ps(a, b); }
+    static Reg Sub(Reg a, Reg b) { return _mm256_sub_ps(a, b); }
+    static Reg Mul(Reg a, Reg b) { return _mm256_mul_ps(a, b); }
+    static Reg Div(Reg a, Reg b) { return _mm256_div_ps(a, b); }
+    static Reg Min(Reg a, Reg b) { return _mm256_min_ps(a, b); }
+    static Reg Max(Reg a, Reg b) { return _mm256_max_ps(a, b); }
+    static Reg Floor(Reg a) { return _mm256_floor_ps(a); }
+    static Reg Fma(Reg a, Reg b, Reg c) { return _mm256_fmadd_ps(a, b, c); } // a * b + c, rounded once
+    static Reg Abs(Reg a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+    static Reg CmpLt(Reg a, Reg b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static Reg CmpLe(Reg a, Reg b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    static Reg CmpEq(Reg a, Reg b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+    static Reg And(Reg a, Reg b) { return _mm256_and_ps(a, b); }
+    static Reg Or(Reg a, Reg b) { return _mm256_or_ps(a, b); }
+    static Reg AndNot(Reg a, Reg b) { return _mm256_andnot_ps(a, b); }
+    static Reg Blend(Reg mask, Reg a, Reg b) { return _mm256_blendv_ps(b, a, mask); }
+    static Reg MaskAdd(Reg src, Mask k, Reg a, Reg b) { return _mm256_blendv_ps(src, _mm256_add_ps(a, b), k); }
+    static Reg MaskMov(Reg src, Mask k, Reg a) { return _mm256_blendv_ps(src, a, k); }
+    static int MoveMask(Reg a) { return _mm256_movemask_ps(a); }
+    static Reg Exponent(Reg a) { return _mm256_sub_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(_mm256_castps_si256(a), 23)), _mm256_set1_ps(127.0f)); }
+    static Reg Mantissa(Reg a) { return _mm256_or_ps(_mm256_and_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(0x007FFFFF))), _mm256_set1_ps(1.0f)); }
+    static Reg Pow2(Reg n) { return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_castps_si256(_mm256_add_ps(n, _mm256_set1_ps(8388608.0f + 127.0f))), 23)); }
+};
+
+// AVX, 4 doubles
+struct AvxD
+{
+    using Reg = __m256d;
+    using Mask = Reg;
+    using Scalar = double;
+    static constexpr int Lanes = 4;
+
+    static Reg Set1(Scalar a) { return _mm256_set1_pd(a); }
+    static Reg Zero() { return _mm256_setzero_pd(); }
+    static Reg Load(const Scalar* p) { return _mm256_loadu_pd(p); }
+    static void Store(Scalar* p, Reg a) { _mm256_storeu_pd(p, a); }
+    static Reg Add(Reg a, Reg b) { return _mm256_add_pd(a, b); }
+    static Reg Sub(Reg a, Reg b) { return _mm256_sub_pd(a, b); }
+    static Reg Mul(Reg a, Reg b) { return _mm256_mul_pd(a, b); }
+    static Reg Div(Reg a, Reg b) { return _mm256_div_pd(a, b); }
+    static Reg Min(Reg a, Reg b) { return _mm256_min_pd(a, b); }
+    static Reg Max(Reg a, Reg b) { return _mm256_max_pd(a, b); }
+    static Reg Floor(Reg a) { return _mm256_floor_pd(a); }
+    static Reg Fma(Reg a, Reg b, Reg c) { return _mm256_fmadd_pd(a, b, c); }
+    static Reg Fms(Reg a, Reg b, Reg c) { return _mm256_fmsub_pd(a, b, c); } // a * b - c, rounded once
+    static Reg Abs(Reg a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+    static Reg CmpLt(Reg a, Reg b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+    static Reg CmpLe(Reg a, Reg b) { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+    static Reg CmpEq(Reg a, Reg b) { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+    static Reg And(Reg a, Reg b) { return _mm256_and_pd(a, b); }
+    static Reg Or(Reg a, Reg b) { return _mm256_or_pd(a, b); }
+    static Reg AndNot(Reg a, Reg b) { return _mm256_andnot_pd(a, b); }
+    static Reg Blend(Reg mask, Reg a, Reg b) { return _mm256_blendv_pd(b, a, mask); }
+    static Reg MaskAdd(Reg src, Mask k, Reg a, Reg b) { return _mm256_blendv_pd(src, _mm256_add_pd(a, b), k); }
+    static Reg MaskMov(Reg src, Mask k, Reg a) { return _mm256_blendv_pd(src, a, k); }
+    static Reg Gather(const Scalar* p, Reg index) { return _mm256_i32gather_pd(p, _mm256_cvttpd_epi32(index), 8); }
+    static int MoveMask(Reg a) { return _mm256_movemask_pd(a); }
+    static Reg Exponent(Reg a)
+    {
+        const __m256d magic = _mm256_set1_pd(4503599627370496.0);
+        return _mm256_sub_pd(_mm256_or_pd(_mm256_castsi256_pd(_mm256_srli_epi64(_mm256_castpd_si256(a), 52)), magic), _mm256_set1_pd(4503599627370496.0 + 1023.0));
+    }
+    static Reg Mantissa(Reg a) { return _mm256_or_pd(_mm256_and_pd(a, _mm256_castsi256_pd(_mm256_set1_epi64x(0x000FFFFFFFFFFFFF))), _mm256_set1_pd(1.0)); }
+    static Reg Pow2(Reg n) { return _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_castpd_si256(_mm256_add_pd(n, _mm256_set1_pd(4503599627370496.0 + 1023.0))), 52)); }
+};
+
+// AVX-512 compares give a mask register (one bit per lane) instead of a register of all ones,
+// and most instructions take a mask of the lanes to write, so the streaming loop has its own kernel below
+
+// AVX-512, 16 floats
+struct Avx512F
+{
+    using Reg = __m512;
+    using Scalar = float;
+    using Mask = __mmask16;
+    static constexpr int Lanes = 16;
+
+    static Reg Set1(Scalar a) { return _mm512_set1_ps(a); }
+    static Reg Zero() { return _mm512_setzero_ps(); }
+    static Reg Load(const Scalar* p) { return _mm512_loadu_ps(p); }
+    static void Store(Scalar* p, Reg a) { _mm512_storeu_ps(p, a); }
+    static Reg Add(Reg a, Reg b) { return _mm512_add_ps(a, b); }
+    static Reg Sub(Reg a, Reg b) { return _mm512_sub_ps(a, b); }
+    static Reg Mul(Reg a, Reg b) { return _mm512_mul_ps(a, b); }
+    static Reg Div(Reg a, Reg b) { return _mm512_div_ps(a, b); }
+    static Reg Min(Reg a, Reg b) { return _mm512_min_ps(a, b); }
+    static Reg Max(Reg a, Reg b) { return _mm512_max_ps(a, b); }
+    static Reg Floor(Reg a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+    static Reg Fma(Reg a, Reg b, Reg c) { return _mm512_fmadd_ps(a, b, c); }
+    static Reg Abs(Reg a) { return _mm512_abs_ps(a); }
+    static Mask CmpLt(Reg a, Reg b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+    static Mask CmpLe(Reg a, Reg b) { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+    static Mask CmpEq(Reg a, Reg b) { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+    static Reg MaskAdd(Reg src, Mask k, Reg a, Reg b) { return _mm512_mask_add_ps(src, k, a, b); } // k ? a + b : src
+    static Reg MaskMov(Reg src, Mask k, Reg a) { return _mm512_mask_mov_ps(src, k, a); }            // k ? a : src
+    static Reg MaskLoad(Reg src, Mask k, const Scalar* p) { return _mm512_mask_loadu_ps(src, k, p); }
+    static Mask And(Mask a, Mask b) { return static_cast<Mask>(a & b); }
+    static Mask Or(Mask a, Mask b) { return static_cast<Mask>(a | b); }
+    static Mask AndNot(Mask a, Mask b) { return static_cast<Mask>(~a & b); }
+    static int MoveMask(Mask a) { return a; }
+    static Reg Exponent(Reg a) { return _mm512_getexp_ps(a); }
+    static Reg Mantissa(Reg a) { return _mm512_getmant_ps(a, _MM_MANT_NORM_1_2, _MM_MANT_SIGN_zero); }
+    static Reg Pow2(Reg n) { return _mm512_scalef_ps(_mm512_set1_ps(1.0f), n); }
+};
+
+// AVX-512, 8 doubles
+struct Avx512D
+{
+    using Reg = __m512d;
+    using Scalar = double;
+    using Mask = __mmask8;
+    static constexpr int Lanes = 8;
+
+    static Reg Set1(Scalar a) { return _mm512_set1_pd(a); }
+    static Reg Zero() { return _mm512_setzero_pd(); }
+    static Reg Load(const Scalar* p) { return _mm512_loadu_pd(p); }
+    static void Store(Scalar* p, Reg a) { _mm512_storeu_pd(p, a); }
+    static Reg Add(Reg a, Reg b) { return _mm512_add_pd(a, b); }
+    static Reg Sub(Reg a, Reg b) { return _mm512_sub_pd(a, b); }
+    static Reg Mul(Reg a, Reg b) { return _mm512_mul_pd(a, b); }
+    static Reg Div(Reg a, Reg b) { return _mm512_div_pd(a, b); }
+    static Reg Min(Reg a, Reg b) { return _mm512_min_pd(a, b); }
+    static Reg Max(Reg a, Reg b) { return _mm512_max_pd(a, b); }
+    static Reg Floor(Reg a) { return _mm512_roundscale_pd(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+    static Reg Fma(Reg a, Reg b, Reg c) { return _mm512_fmadd_pd(a, b, c); }
+    static Reg Abs(Reg a) { return _mm512_abs_pd(a); }
+    static Mask CmpLt(Reg a, Reg b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+    static Mask CmpLe(Reg a, Reg b) { return _mm512_cmp_pd_mask(a, b, _CMP_LE_OQ); }
+    static Mask CmpEq(Reg a, Reg b) { return _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ); }
+    static Reg MaskAdd(Reg src, Mask k, Reg a, Reg b) { return _mm512_mask_add_pd(src, k, a, b); }
+    static Reg MaskMov(Reg src, Mask k, Reg a) { return _mm512_mask_mov_pd(src, k, a); }
+    static Reg MaskLoad(Reg src, Mask k, const Scalar* p) { return _mm512_mask_loadu_pd(src, k, p); }
+    static Mask And(Mask a, Mask b) { return static_cast<Mask>(a & b); }
+    static Mask Or(Mask a, Mask b) { return static_cast<Mask>(a | b); }
+    static Mask AndNot(Mask a, Mask b) { return static_cast<Mask>(~a & b); }
+    static int MoveMask(Mask a) { return a; }
+    static Reg Exponent(Reg a) { return _mm512_getexp_pd(a); }
+    static Reg Mantissa(Reg a) { return _mm512_getmant_pd(a, _MM_MANT_NORM_1_2, _MM_MANT_SIGN_zero); }
+    static Reg Pow2(Reg n) { return _mm512_scalef_pd(_mm512_set1_pd(1.0), n); }
+};
+
+// State of one orbit per lane
+// r is |z|^2 of the previous z, which is what the escape test looks at
+template<class V>
+struct Orbit
+{
+    typename V::Reg x, y;
+    typename V::Reg xprev, yprev;
+    typename V::Reg r;
+};
+
+// Formulas whose next point depends on the previous one too (Pheonix) declare
+// static constexpr bool SecondOrder = true. Their orbit only repeats once (x, y) and (xprev, yprev)
+// both come back around, so cycle detection compares the previous point as well
+template<class Formula>
+constexpr bool IsSecondOrder = requires { requires Formula::SecondOrder; };
+
+// A list of pixels for the kernels to compute
+struct StreamJob
+{
+    const int* pixels;  // Pixel indices (y * width + x)
+    int numPixels;
+    int width;
+
+    // Complex plane position of pixel 0 and the size of a pixel
+    double xMin, yMin;
+    double dx, dy;
+
+    int* iterations;    // Output, one per entry in pixels
+};
+
+// Streaming ("ragged") escape time loop
+// As soon as a lane's pixel escapes (or runs out of iterations) its count is written back and
+// the next pixel of the job is swapped into that lane, so lanes never idle waiting on their
+// neighbours. formula.Step<V>(orbit, cx, cy) does one iteration, and an optional
+// Formula::Interior(cx, cy) lets a pixel skip the loop entirely.
+// The formula is passed as an object so it can carry parameters (the Multibrot exponent).
+// Orbits that come back within periodTolerance of an earlier point are retired as inside the set,
+// returns how many pixels were retired that way.
+template<class V, class Formula>
+int StreamKernel(const StreamJob& job, const Formula& formula, int maxIterations, float rMax, double periodTolerance)
+{
+    using Reg = typename V::Reg;
+    using Scalar = typename V::Scalar;
+    constexpr int L = V::Lanes;
+
+    if (job.numPixels <= 0) return 0;
+
+    // Per lane bookkeeping, only touched when a lane is refilled
+    alignas(64) Scalar cxLane[L], cyLane[L], nLane[L];
+    alignas(64) Scalar xLane[L], yLane[L], xprevLane[L], yprevLane[L], rLane[L], validLane[L];
+    alignas(64) Scalar xRefLane[L], yRefLane[L], checkLane[L]; // Cycle detection reference point and when it moves next
+    alignas(64) Scalar xprevRefLane[L], yprevRefLane[L];        // and its previous point, for second order formulas
+    int slot[L]; // Which entry of job.pixels each lane is working on (-1 = none left)
+    int retired = 0;
+
+    const Scalar allSet = [] { Scalar s; memset(&s, 0xFF, sizeof(s)); return s; }(); // Mask value for "true"
+    int next = 0;
+
+    // Loads the next pixel of the job into a lane (or parks the lane when the job is empty)
+    auto refill = [&](int lane)
+    {
+        xLane[lane] = yLane[lane] = xprevLane[lane] = yprevLane[lane] = rLane[lane] = nLane[lane] = 0;
+        xRefLane[lane] = yRefLane[lane] = xprevRefLane[lane] = yprevRefLane[lane] = 0;
+        checkLane[lane] = 1;
+
+        // Pixels the formula can prove are inside the set never take up a lane
+        if constexpr (requires { Formula::Interior(0.0, 0.0); })
+        {
+            while (next < job.numPixels)
+            {
+                int pixel = job.pixels[next];
+                if (!Formula::Interior(job.xMin + (pixel % job.width) * job.dx, job.yMin + (pixel / job.width) * job.dy)) break;
+
+                job.iterations[next++] = maxIterations;
+            }
+        }
+
+        if (next < job.numPixels)
+        {
+            int pixel = job.pixels[next];
+            cxLane[lane] = static_cast<Scalar>(job.xMin + (pixel % job.width) * job.dx);
+            cyLane[lane] = static_cast<Scalar>(job.yMin + (pixel / job.width) * job.dy);
+            validLane[lane] = allSet;
+            slot[lane] = next++;
+        }
+        else
+        {
+            cxLane[lane] = cyLane[lane] = 0;
+            validLane[lane] = 0;
+            slot[lane] = -1;
+        }
+    };
+
+    for (int lane = 0; lane < L; ++lane)
+    {
+        refill(lane);
+    }
+
+    // Lanes are filled in order, so if lane 0 got nothing every pixel was interior
+    if (slot[0] < 0) return 0;
+
+    const Reg vrMax = V::Set1(static_cast<Scalar>(rMax));
+    const Reg vMaxIter = V::Set1(static_cast<Scalar>(maxIterations));
+    const Reg one = V::Set1(1);
+    const Reg tolerance = V::Set1(static_cast<Scalar>(periodTolerance));
+
+    Orbit<V> z;
+    z.x = z.y = z.xprev = z.yprev = z.r = V::Zero();
+    Reg cx = V::Load(cxLane), cy = V::Load(cyLane);
+    Reg n = V::Zero(); // Counts are kept as floats, exact far past m_maxIterations
+    Reg valid = V::Load(validLane);
+    Reg xRef = V::Zero(), yRef = V::Zero();
+    Reg xprevRef = V::Zero(), yprevRef = V::Zero();
+    Reg check = V::Load(checkLane);
+
+    while (true)
+    {
+        Reg active = V::And(V::And(V::CmpLt(z.r, vrMax), V::CmpLt(n, vMaxIter)), valid);
+        int done = V::MoveMask(V::AndNot(active, valid));
+
+        if (done)
+        {
+            // Spill the lanes, write back the finished ones and swap in new pixels
+            V::Store(nLane, n);
+            V::Store(xLane, z.x); V::Store(yLane, z.y);
+            V::Store(xprevLane, z.xprev); V::Store(yprevLane, z.yprev);
+            V::Store(rLane, z.r);
+            V::Store(xRefLane, xRef); V::Store(yRefLane, yRef);
+            if constexpr (IsSecondOrder<Formula>)
+            {
+                V::Store(xprevRefLane, xprevRef); V::Store(yprevRefLane, yprevRef);
+            }
+            V::Store(checkLane, check);
+
+            for (int lane = 0; lane < L; ++lane)
+            {
+                if (done & (1 << lane))
+                {
+                    job.iterations[slot[lane]] = static_cast<int>(nLane[lane]);
+                    refill(lane);
+                }
+            }
+
+            n = V::Load(nLane);
+            z.x = V::Load(xLane); z.y = V::Load(yLane);
+            z.xprev = V::Load(xprevLane); z.yprev = V::Load(yprevLane);
+            z.r = V::Load(rLane);
+            xRef = V::Load(xRefLane); yRef = V::Load(yRefLane);
+            if constexpr (IsSecondOrder<Formula>)
+            {
+                xprevRef = V::Load(xprevRefLane); yprevRef = V::Load(yprevRefLane);
+            }
+            check = V::Load(checkLane);
+            cx = V::Load(cxLane); cy = V::Load(cyLane);
+            valid = V::Load(validLane);
+
+            // Every lane that still has a pixel has just been (re)checked
+            if (!V::MoveMask(valid)) break;
+            active = valid;
+        }
+
+        formula.template Step<V>(z, cx, cy);
+        n = V::Add(n, V::And(active, one));
+
+        // Brent cycle detection, every lane keeps its own schedule since lanes start at different times
+        // It's VectorPeriodCheck's, the reference moves after iterations 1, 3, 7, 15... so streaming
+        // retires the same pixels as the block kernels
+        // A lane that comes back around jumps straight to maxIterations and is written back on the next pass
+        Reg hit = V::And(active, V::And(
+            V::CmpLe(V::Abs(V::Sub(z.x, xRef)), tolerance),
+            V::CmpLe(V::Abs(V::Sub(z.y, yRef)), tolerance)));
+        if constexpr (IsSecondOrder<Formula>)
+        {
+            hit = V::And(hit, V::And(
+                V::CmpLe(V::Abs(V::Sub(z.xprev, xprevRef)), tolerance),
+                V::CmpLe(V::Abs(V::Sub(z.yprev, yprevRef)), tolerance)));
+        }
+        if (int hitLanes = V::MoveMask(hit))
+        {
+            retired += std::popcount(static_cast<unsigned>(hitLanes));
+            n = V::Blend(hit, vMaxIter, n);
+        }
+
+        Reg move = V::CmpEq(n, check);
+        xRef = V::Blend(move, z.x, xRef);
+        yRef = V::Blend(move, z.y, yRef);
+        if constexpr (IsSecondOrder<Formula>)
+        {
+            xprevRef = V::Blend(move, z.xprev, xprevRef);
+            yprevRef = V::Blend(move, z.yprev, yprevRef);
+        }
+        check = V::Blend(move, V::Add(V::Add(check, check), one), check);
+    }
+
+    return retired;
+}
+
+// StreamKernel for the AVX-512 wrappers, the lane bookkeeping is done with mask registers
+// Only the lanes that finished are written back and reloaded, the rest keep their registers
+template<class V, class Formula>
+int StreamKernelMasked(const StreamJob& job, const Formula& formula, int maxIterations, float rMax, double periodTolerance)
+{
+    using Reg = typename V::Reg;
+    using Scalar = typename V::Scalar;
+    using Mask = typename V::Mask;
+    constexpr int L = V::Lanes;
+
+    if (job.numPixels <= 0) return 0;
+
+    alignas(64) Scalar cxLane[L], cyLane[L], nLane[L];
+    int slot[L];
+    int retired = 0;
+
+    Mask valid = 0;
+    int next = 0;
+
+    // Every orbit starts at zero, so a new pixel only has to bring its c
+    auto refill = [&](int lane)
+    {
+        if constexpr (requires { Formula::Interior(0.0, 0.0); })
+        {
+            while (next < job.numPixels)
+            {
+                int pixel = job.pixels[next];
+                if (!Formula::Interior(job.xMin + (pixel % job.width) * job.dx, job.yMin + (pixel / job.width) * job.dy)) break;
+
+                job.iterations[next++] = maxIterations;
+            }
+        }
+
+        if (next < job.numPixels)
+        {
+            int pixel = job.pixels[next];
+            cxLane[lane] = static_cast<Scalar>(job.xMin + (pixel % job.width) * job.dx);
+            cyLane[lane] = static_cast<Scalar>(job.yMin + (pixel / job.width) * job.dy);
+            valid = static_cast<Mask>(valid | (1u << lane));
+            slot[lane] = next++;
+        }
+        else
+        {
+            cxLane[lane] = cyLane[lane] = 0;
+            valid = static_cast<Mask>(valid & ~(1u << lane));
+            slot[lane] = -1;
+        }
+    };
+
+    for (int lane = 0; lane < L; ++lane)
+    {
+        refill(lane);
+    }
+
+    if (slot[0] < 0) return 0;
+
+    const Reg vrMax = V::Set1(static_cast<Scalar>(rMax));
+    const Reg vMaxIter = V::Set1(static_cast<Scalar>(maxIterations));
+    const Reg zero = V::Zero();
+    const Reg one = V::Set1(1);
+    const Reg tolerance = V::Set1(static_cast<Scalar>(periodTolerance));
+
+    Orbit<V> z;
+    z.x = z.y = z.xprev = z.yprev = z.r = zero;
+    Reg cx = V::Load(cxLane), cy = V::Load(cyLane);
+    Reg n = zero;
+    Reg xRef = zero, yRef = zero;
+    Reg xprevRef = zero, yprevRef = zero;
+    Reg check = one;
+
+    while (true)
+    {
+        Mask active = static_cast<Mask>(V::CmpLt(z.r, vrMax) & V::CmpLt(n, vMaxIter) & valid);
+        Mask done = static_cast<Mask>(valid & ~active);
+
+        if (done)
+        {
+            V::Store(nLane, n);
+
+            for (int lane = 0; lane < L; ++lane)
+            {
+                if (done & (1u << lane))
+                {
+                    job.iterations[slot[lane]] = static_cast<int>(nLane[lane]);
+                    refill(lane);
+                }
+            }
+
+            // Reset the refilled lanes, masked so the running lanes aren't touched
+            z.x = V::MaskMov(z.x, done, zero); z.y = V::MaskMov(z.y, done, zero);
+            z.xprev = V::MaskMov(z.xprev, done, zero); z.yprev = V::MaskMov(z.yprev, done, zero);
+            z.r = V::MaskMov(z.r, done, zero);
+            n = V::MaskMov(n, done, zero);
+            xRef = V::MaskMov(xRef, done, zero); yRef = V::MaskMov(yRef, done, zero);
+            if constexpr (IsSecondOrder<Formula>)
+            {
+                xprevRef = V::MaskMov(xprevRef, done, zero); yprevRef = V::MaskMov(yprevRef, done, zero);
+            }
+            check = V::MaskMov(check, done, one);
+            cx = V::MaskLoad(cx, done, cxLane); cy = V::MaskLoad(cy, done, cyLane);
+
+            if (!valid) break;
+            active = valid;
+        }
+
+        formula.template Step<V>(z, cx, cy);
+        n = V::MaskAdd(n, active, n, one);
+
+        // Brent cycle detection, the same schedule per lane as StreamKernel
+        Mask hit = static_cast<Mask>(active &
+            V::CmpLe(V::Abs(V::Sub(z.x, xRef)), tolerance) &
+            V::CmpLe(V::Abs(V::Sub(z.y, yRef)), tolerance));
+        if constexpr (IsSecondOrder<Formula>)
+        {
+            hit = static_cast<Mask>(hit &
+                V::CmpLe(V::Abs(V::Sub(z.xprev, xprevRef)), tolerance) &
+                V::CmpLe(V::Abs(V::Sub(z.yprev, yprevRef)), tolerance));
+        }
+        if (hit)
+        {
+            retired += std::popcount(static_cast<unsigned>(hit));
+            n = V::MaskMov(n, hit, vMaxIter);
+        }
+
+        Mask move = V::CmpEq(n, check);
+        xRef = V::MaskMov(xRef, move, z.x);
+        yRef = V::MaskMov(yRef, move, z.y);
+        if constexpr (IsSecondOrder<Formula>)
+        {
+            xprevRef = V::MaskMov(xprevRef, move, z.xprev);
+            yprevRef = V::MaskMov(yprevRef, move, z.yprev);
+        }
+        check = V::MaskAdd(check, move, V::Add(check, check), one);
+    }
+
+    return retired;
+}
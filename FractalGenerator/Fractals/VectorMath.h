@@ -0,0 +1,171 @@
+/*********************************************************************************************
+**
+**	File Name:		vectormath.h
+**	Description:	This is the header file that contains the elementary functions (log, exp,
+**                  atan2, sin and cos) for every register width, built out of the wrapper ops
+**
+**	Author:			Clarke Needles
+**	Created:		10/17/2026
+**
+**********************************************************************************************/
+
+#pragma once
+
+#include <cmath>
+#include <type_traits>
+#include "Simd.h"
+
+// The C++ wrappers just call the library, the SIMD ones reduce the argument into a small range
+// and evaluate a polynomial there. The polynomials are good to about double precision, floats
+// simply carry them to float precision.
+
+template<class V>
+constexpr bool IsScalarWrapper = std::is_floating_point_v<typename V::Reg>;
+
+// c[0] + x * (c[1] + x * (c[2] + ...))
+template<class V, int N>
+inline typename V::Reg Polynomial(typename V::Reg x, const double (&c)[N])
+{
+    using Scalar = typename V::Scalar;
+
+    auto sum = V::Set1(Scalar(c[N - 1]));
+    for (int i = N - 2; i >= 0; --i)
+    {
+        sum = V::Fma(sum, x, V::Set1(Scalar(c[i])));
+    }
+
+    return sum;
+}
+
+// Natural log of a positive, normal x
+template<class V>
+inline typename V::Reg Log(typename V::Reg x)
+{
+    if constexpr (IsScalarWrapper<V>)
+    {
+        return std::log(x);
+    }
+    else
+    {
+        using Scalar = typename V::Scalar;
+        const auto one = V::Set1(Scalar(1));
+
+        // x = m * 2^e with m moved into [sqrt(1/2), sqrt(2))
+        auto e = V::Exponent(x);
+        auto m = V::Mantissa(x);
+        auto big = V::CmpLt(V::Set1(Scalar(1.4142135623730951)), m);
+        m = V::MaskMov(m, big, V::Mul(m, V::Set1(Scalar(0.5))));
+        e = V::MaskAdd(e, big, e, one);
+
+        // log(m) = 2 atanh(f) with f = (m - 1) / (m + 1), |f| < 0.172
+        static constexpr double c[] = { 2.0, 2.0 / 3, 2.0 / 5, 2.0 / 7, 2.0 / 9, 2.0 / 11, 2.0 / 13, 2.0 / 15, 2.0 / 17, 2.0 / 19 };
+        auto f = V::Div(V::Sub(m, one), V::Add(m, one));
+        auto logm = V::Mul(f, Polynomial<V>(V::Mul(f, f), c));
+
+        return V::Fma(e, V::Set1(Scalar(0.6931471805599453)), logm);
+    }
+}
+
+// e^x, clamped to what the type can hold
+template<class V>
+inline typename V::Reg Exp(typename V::Reg x)
+{
+    if constexpr (IsScalarWrapper<V>)
+    {
+        return std::exp(x);
+    }
+    else
+    {
+        using Scalar = typename V::Scalar;
+        constexpr double limit = sizeof(Scalar) == 4 ? 87.0 : 708.0;
+
+        // x = n ln2 + r with |r| <= ln2 / 2, ln2 split in two so n ln2 comes off exactly
+        x = V::Min(V::Max(x, V::Set1(Scalar(-limit))), V::Set1(Scalar(limit)));
+        auto n = V::Floor(V::Fma(x, V::Set1(Scalar(1.4426950408889634)), V::Set1(Scalar(0.5))));
+        auto r = V::Sub(x, V::Mul(n, V::Set1(Scalar(6.93145751953125e-1))));
+        r = V::Sub(r, V::Mul(n, V::Set1(Scalar(1.42860682030941723212e-6))));
+
+        // Taylor series to r^12
+        static constexpr double c[] = { 1.0, 1.0, 1.0 / 2, 1.0 / 6, 1.0 / 24, 1.0 / 120, 1.0 / 720, 1.0 / 5040, 1.0 / 40320,
+            1.0 / 362880, 1.0 / 3628800, 1.0 / 39916800, 1.0 / 479001600 };
+
+        return V::Mul(Polynomial<V>(r, c), V::Pow2(n));
+    }
+}
+
+// Angle of (x, y) in [-pi, pi]
+template<class V>
+inline typename V::Reg Atan2(typename V::Reg y, typename V::Reg x)
+{
+    if constexpr (IsScalarWrapper<V>)
+    {
+        return std::atan2(y, x);
+    }
+    else
+    {
+        using Scalar = typename V::Scalar;
+        const auto zero = V::Zero();
+        const auto one = V::Set1(Scalar(1));
+
+        // atan of t = min / max in [0, 1], past tan(pi / 8) it's pi / 4 + atan((t - 1) / (t + 1))
+        auto ax = V::Abs(x), ay = V::Abs(y);
+        auto t = V::Div(V::Min(ax, ay), V::Max(ax, ay));
+        auto far = V::CmpLt(V::Set1(Scalar(0.41421356237309503)), t);
+        t = V::MaskMov(t, far, V::Div(V::Sub(t, one), V::Add(t, one)));
+
+        // Cephes rational approximation, |t| <= tan(pi / 8)
+        static constexpr double p[] = { -6.485021904942025371773e1, -1.228866684490136173410e2, -7.500855792314704667340e1,
+            -1.615753718733365076637e1, -8.750608600031904122785e-1 };
+        static constexpr double q[] = { 1.945506571482613964425e2, 4.853903996359136964868e2, 4.328810604912902668951e2,
+            1.650270098316988542046e2, 2.485846490142306297962e1, 1.0 };
+        auto t2 = V::Mul(t, t);
+        auto a = V::Fma(V::Mul(t, t2), V::Div(Polynomial<V>(t2, p), Polynomial<V>(t2, q)), t);
+        a = V::MaskAdd(a, far, a, V::Set1(Scalar(0.78539816339744831)));
+
+        // Back out to the right octant
+        a = V::MaskMov(a, V::CmpLt(ax, ay), V::Sub(V::Set1(Scalar(1.5707963267948966)), a));
+        a = V::MaskMov(a, V::CmpLt(x, zero), V::Sub(V::Set1(Scalar(3.1415926535897932)), a));
+        a = V::MaskMov(a, V::CmpLt(y, zero), V::Sub(zero, a));
+
+        // 0 / 0 where x = y = 0
+        return V::MaskMov(a, V::CmpEq(V::Max(ax, ay), zero), zero);
+    }
+}
+
+template<class V>
+inline void SinCos(typename V::Reg a, typename V::Reg& sin, typename V::Reg& cos)
+{
+    if constexpr (IsScalarWrapper<V>)
+    {
+        sin = std::sin(a);
+        cos = std::cos(a);
+    }
+    else
+    {
+        using Scalar = typename V::Scalar;
+        const auto zero = V::Zero();
+
+        // a = q pi / 2 + r with |r| <= pi / 4, pi / 2 split in three
+        auto q = V::Floor(V::Fma(a, V::Set1(Scalar(0.63661977236758134)), V::Set1(Scalar(0.5))));
+        auto r = V::Sub(a, V::Mul(q, V::Set1(Scalar(1.57079625129699707031))));
+        r = V::Sub(r, V::Mul(q, V::Set1(Scalar(7.54978941586159635335e-8))));
+        r = V::Sub(r, V::Mul(q, V::Set1(Scalar(5.39030285815811905290e-15))));
+
+        // Cephes polynomials on the reduced range
+        static constexpr double s[] = { -1.66666666666666307295e-1, 8.33333333332211858878e-3, -1.98412698295895385996e-4,
+            2.75573136213857245213e-6, -2.50507477628578072866e-8, 1.58962301576546568060e-10 };
+        static constexpr double c[] = { 4.16666666666665929218e-2, -1.38888888888730564116e-3, 2.48015872888517045348e-5,
+            -2.75573141792967388112e-7, 2.08757008419747316778e-9, -1.13585365213876817300e-11 };
+        auto r2 = V::Mul(r, r);
+        auto sinr = V::Fma(V::Mul(r, r2), Polynomial<V>(r2, s), r);
+        auto cosr = V::Fma(V::Mul(r2, r2), Polynomial<V>(r2, c), V::Fma(r2, V::Set1(Scalar(-0.5)), V::Set1(Scalar(1))));
+
+        // Quadrant q mod 4 swaps the two and picks the signs
+        auto quadrant = V::Sub(q, V::Mul(V::Set1(Scalar(4)), V::Floor(V::Mul(q, V::Set1(Scalar(0.25))))));
+        auto odd = V::Or(V::CmpEq(quadrant, V::Set1(Scalar(1))), V::CmpEq(quadrant, V::Set1(Scalar(3))));
+        sin = V::MaskMov(sinr, odd, cosr);
+        cos = V::MaskMov(cosr, odd, sinr);
+        sin = V::MaskMov(sin, V::CmpLe(V::Set1(Scalar(2)), quadrant), V::Sub(zero, sin));
+        cos = V::MaskMov(cos, V::Or(V::CmpEq(quadrant, V::Set1(Scalar(1))), V::CmpEq(quadrant, V::Set1(Scalar(2)))), V::Sub(zero, cos));
+    }
+}
@@ -0,0 +1,108 @@
+/*********************************************************************************************
+**
+**	File Name:		FrameRing.cpp
+**	Description:	This is the file that contains the function definitions for the ring of
+**                  frame buffers
+**
+**	Author:			Clarke Needles
+**	Created:		10/17/2026
+**
+**********************************************************************************************/
+
+#include "FrameRing.h"
+
+#include <malloc.h>
+
+FrameRing::FrameRing(int numFrames, int numPixels)
+{
+    // Aligned for the colouring pass's vector stores
+    for (int i = 0; i < numFrames; ++i)
+    {
+        m_frames.push_back({ static_cast<Colour*>(_aligned_malloc(sizeof(Colour) * numPixels, 64)), 0 });
+    }
+}
+
+FrameRing::~FrameRing()
+{
+    for (Frame& frame : m_frames)
+    {
+        _aligned_free(frame.pixels);
+    }
+}
+
+FrameRing::Frame& FrameRing::Find(const Colour* pixels)
+{
+    for (Frame& frame : m_frames)
+    {
+        if (frame.pixels == pixels)
+        {
+            return frame;
+        }
+    }
+
+    return m_frames.front();
+}
+
+Colour* FrameRing::Acquire()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    Frame* free = nullptr;
+    m_freeCondition.wait(lock, [&]
+    {
+        for (Frame& frame : m_frames)
+        {
+            if (frame.users == 0)
+            {
+                free = &frame;
+                return true;
+            }
+        }
+
+        return false;
+    });
+
+    free->users = 1;
+    return free->pixels;
+}
+
+void FrameRing::Publish(Colour* pixels)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // The render thread's hold on the frame carries over as the front's
+        if (m_front)
+        {
+            --m_front->users;
+        }
+        m_front = &Find(pixels);
+    }
+    m_freeCondition.notify_all();
+}
+
+Colour* FrameRing::AcquireFront()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_front)
+    {
+        return nullptr;
+    }
+
+    ++m_front->users;
+    return m_front->pixels;
+}
+
+void FrameRing::Release(Colour* pixels)
+{
+    if (!pixels)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        --Find(pixels).users;
+    }
+    m_freeCondition.notify_all();
+}
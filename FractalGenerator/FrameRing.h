@@ -0,0 +1,60 @@
+/*********************************************************************************************
+**
+**	File Name:		FrameRing.h
+**	Description:	This is the header file that contains the ring of pixel buffers frames are
+**                  rendered into and shown from, so the next frame can be rendered while the
+**                  last one is still on its way to the window
+**
+**	Author:			Clarke Needles
+**	Created:		10/17/2026
+**
+**********************************************************************************************/
+
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <condition_variable>
+#include "Colour.h"
+
+class FrameRing
+{
+private:
+    // A frame is free once nobody uses it
+    // The render thread holds the one it renders into, the front frame is held for as long as it
+    // is the front, and the window holds it again while painting it
+    struct Frame
+    {
+        Colour* pixels;
+        int users;
+    };
+
+    std::vector<Frame> m_frames;
+    Frame* m_front = nullptr;
+
+    std::mutex m_mutex;
+    std::condition_variable m_freeCondition;
+
+private:
+    Frame& Find(const Colour* pixels);
+
+public:
+    FrameRing(int numFrames, int numPixels);
+
+    ~FrameRing();
+
+    FrameRing(const FrameRing&) = delete;
+    FrameRing& operator=(const FrameRing&) = delete;
+
+    // Taking a free frame to render into, waits until one is given back if there are none
+    Colour* Acquire();
+
+    // Handing over a finished frame, it becomes the front and the old front is let go
+    void Publish(Colour* pixels);
+
+    // The front frame (nullptr before the first one), it isn't rendered over until it's released
+    Colour* AcquireFront();
+
+    // Giving back a frame from Acquire (that was never published) or AcquireFront
+    void Release(Colour* pixels);
+};
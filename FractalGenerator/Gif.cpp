@@ -27,6 +27,12 @@
 //
 
 #include "gif.h"
+#include "ThreadPool.h"
+
+#include <emmintrin.h>
+
+// nodes with at least this many pixels have their halves split in parallel
+const int kGifParallelPixels = 32768;
 
 // max, min, and abs functions
 int GifIMax(int l, int r) { return l > r ? l : r; }
@@ -87,25 +93,12 @@ void GifGetClosestPaletteColor(GifPalette* pPal, int r, int g, int b, int* bestI
 
 void GifSwapPixels(uint8_t* image, int pixA, int pixB)
 {
-    uint8_t rA = image[pixA * 4];
-    uint8_t gA = image[pixA * 4 + 1];
-    uint8_t bA = image[pixA * 4 + 2];
-    uint8_t aA = image[pixA * 4 + 3];
-
-    uint8_t rB = image[pixB * 4];
-    uint8_t gB = image[pixB * 4 + 1];
-    uint8_t bB = image[pixB * 4 + 2];
-    uint8_t aB = image[pixA * 4 + 3];
-
-    image[pixA * 4] = rB;
-    image[pixA * 4 + 1] = gB;
-    image[pixA * 4 + 2] = bB;
-    image[pixA * 4 + 3] = aB;
-
-    image[pixB * 4] = rA;
-    image[pixB * 4 + 1] = gA;
-    image[pixB * 4 + 2] = bA;
-    image[pixB * 4 + 3] = aA;
+    // a pixel at a time rather than a byte at a time
+    uint32_t a, b;
+    memcpy(&a, image + pixA * 4, 4);
+    memcpy(&b, image + pixB * 4, 4);
+    memcpy(image + pixA * 4, &b, 4);
+    memcpy(image + pixB * 4, &a, 4);
 }
 
 // just the partition operation from quicksort
@@ -163,8 +156,49 @@ int GifPartitionByMean(uint8_t* image, int left, int right, int com, int neededM
     return left;
 }
 
+// per-channel min and max of a run of pixels, four pixels at a time
+void GifMinMax(const uint8_t* image, int numPixels, int* minRGB, int* maxRGB)
+{
+    // each byte lane keeps the min/max of its channel in one of the four pixel slots
+    __m128i mins = _mm_set1_epi8((char)0xff);
+    __m128i maxs = _mm_setzero_si128();
+
+    int ii = 0;
+    for (; ii + 4 <= numPixels; ii += 4)
+    {
+        __m128i pixels = _mm_loadu_si128((const __m128i*)(image + ii * 4));
+        mins = _mm_min_epu8(mins, pixels);
+        maxs = _mm_max_epu8(maxs, pixels);
+    }
+
+    uint8_t minLanes[16], maxLanes[16];
+    _mm_storeu_si128((__m128i*)minLanes, mins);
+    _mm_storeu_si128((__m128i*)maxLanes, maxs);
+
+    for (int com = 0; com < 3; ++com)
+    {
+        int lo = 255, hi = 0;
+        for (int slot = 0; slot < 4; ++slot)
+        {
+            lo = GifIMin(lo, minLanes[slot * 4 + com]);
+            hi = GifIMax(hi, maxLanes[slot * 4 + com]);
+        }
+
+        // the last few pixels that don't fill a vector
+        for (int jj = ii; jj < numPixels; ++jj)
+        {
+            lo = GifIMin(lo, image[jj * 4 + com]);
+            hi = GifIMax(hi, image[jj * 4 + com]);
+        }
+
+        minRGB[com] = lo;
+        maxRGB[com] = hi;
+    }
+}
+
 // Builds a palette by creating a balanced k-d tree of all pixels in the image
-void GifSplitPalette(uint8_t* image, int numPixels, int treeNode, int treeLevel, bool buildForDither, GifPalette* pal)
+// Given a pool, the two halves of each large enough node are split at the same time
+void GifSplitPalette(uint8_t* image, int numPixels, int treeNode, int treeLevel, bool buildForDither, GifPalette* pal, ThreadPool* pool)
 {
     if (numPixels == 0)
         return;
@@ -181,38 +215,16 @@ void GifSplitPalette(uint8_t* image, int numPixels, int treeNode, int treeLevel,
             // Dithering needs at least one color as dark as anything
             // in the image and at least one brightest color -
             // otherwise it builds up error and produces strange artifacts
-            if (entry == 1)
-            {
-                // special case: the darkest color in the image
-                uint32_t r = 255, g = 255, b = 255;
-                for (int ii = 0; ii < numPixels; ++ii)
-                {
-                    r = (uint32_t)GifIMin((int32_t)r, image[ii * 4 + 0]);
-                    g = (uint32_t)GifIMin((int32_t)g, image[ii * 4 + 1]);
-                    b = (uint32_t)GifIMin((int32_t)b, image[ii * 4 + 2]);
-                }
-
-                pal->r[entry] = (uint8_t)r;
-                pal->g[entry] = (uint8_t)g;
-                pal->b[entry] = (uint8_t)b;
-
-                return;
-            }
-
-            if (entry == numColors - 1)
+            if (entry == 1 || entry == numColors - 1)
             {
-                // special case: the lightest color in the image
-                uint32_t r = 0, g = 0, b = 0;
-                for (int ii = 0; ii < numPixels; ++ii)
-                {
-                    r = (uint32_t)GifIMax((int32_t)r, image[ii * 4 + 0]);
-                    g = (uint32_t)GifIMax((int32_t)g, image[ii * 4 + 1]);
-                    b = (uint32_t)GifIMax((int32_t)b, image[ii * 4 + 2]);
-                }
+                int minRGB[3], maxRGB[3];
+                GifMinMax(image, numPixels, minRGB, maxRGB);
 
-                pal->r[entry] = (uint8_t)r;
-                pal->g[entry] = (uint8_t)g;
-                pal->b[entry] = (uint8_t)b;
+                // special cases: the darkest and the lightest color in the image
+                const int* rgb = entry == 1 ? minRGB : maxRGB;
+                pal->r[entry] = (uint8_t)rgb[0];
+                pal->g[entry] = (uint8_t)rgb[1];
+                pal->b[entry] = (uint8_t)rgb[2];
 
                 return;
             }
@@ -243,24 +255,12 @@ void GifSplitPalette(uint8_t* image, int numPixels, int treeNode, int treeLevel,
     }
 
     // Find the axis with the largest range
-    int minR = 255, maxR = 0;
-    int minG = 255, maxG = 0;
-    int minB = 255, maxB = 0;
-    for (int ii = 0; ii < numPixels; ++ii)
-    {
-        int r = image[ii * 4 + 0];
-        int g = image[ii * 4 + 1];
-        int b = image[ii * 4 + 2];
+    int minRGB[3], maxRGB[3];
+    GifMinMax(image, numPixels, minRGB, maxRGB);
 
-        if (r > maxR) maxR = r;
-        if (r < minR) minR = r;
-
-        if (g > maxG) maxG = g;
-        if (g < minG) minG = g;
-
-        if (b > maxB) maxB = b;
-        if (b < minB) minB = b;
-    }
+    int minR = minRGB[0], maxR = maxRGB[0];
+    int minG = minRGB[1], maxG = maxRGB[1];
+    int minB = minRGB[2], maxB = maxRGB[2];
 
     int rRange = maxR - minR;
     int gRange = maxG - minG;
@@ -295,6 +295,16 @@ void GifSplitPalette(uint8_t* image, int numPixels, int treeNode, int treeLevel,
     pal->treeSplitElt[treeNode] = (uint8_t)splitCom;
     pal->treeSplit[treeNode] = (uint8_t)splitValue;
 
+    // the halves cover separate pixels and fill separate nodes, so they can be split side by side
+    if (pool && numPixels >= kGifParallelPixels)
+    {
+        TaskGroup tasks(*pool);
+        tasks.Run([=] { GifSplitPalette(image, subPixelsA, treeNode * 2, treeLevel + 1, buildForDither, pal, pool); });
+        GifSplitPalette(image + subPixelsA * 4, subPixelsB, treeNode * 2 + 1, treeLevel + 1, buildForDither, pal, pool);
+        tasks.Wait();
+        return;
+    }
+
     GifSplitPalette(image, subPixelsA, treeNode * 2, treeLevel + 1, buildForDither, pal);
     GifSplitPalette(image + subPixelsA * 4, subPixelsB, treeNode * 2 + 1, treeLevel + 1, buildForDither, pal);
 }
@@ -327,23 +337,60 @@ int GifPickChangedPixels(const uint8_t* lastFrame, uint8_t* frame, int numPixels
     return numChanged;
 }
 
+// Copies every sampleStep-th pixel (of the changed ones, given a last frame) to the front of
+// outFrame, in one pass over the frame
+int GifSamplePixels(const uint8_t* lastFrame, const uint8_t* frame, uint8_t* outFrame, int numPixels, int sampleStep)
+{
+    int numSampled = 0;
+    int skip = 0;
+
+    for (int ii = 0; ii < numPixels; ++ii)
+    {
+        if (!lastFrame ||
+            lastFrame[ii * 4] != frame[ii * 4] ||
+            lastFrame[ii * 4 + 1] != frame[ii * 4 + 1] ||
+            lastFrame[ii * 4 + 2] != frame[ii * 4 + 2])
+        {
+            if (skip == 0)
+            {
+                memcpy(outFrame + numSampled * 4, frame + ii * 4, 4);
+                ++numSampled;
+                skip = sampleStep;
+            }
+            --skip;
+        }
+    }
+
+    return numSampled;
+}
+
 // Creates a palette by placing all the image pixels in a k-d tree and then averaging the blocks at the bottom.
 // This is known as the "median split" technique
-void GifMakePalette(const uint8_t* lastFrame, const uint8_t* nextFrame, uint32_t width, uint32_t height, int bitDepth, bool buildForDither, GifPalette* pPal)
+// A sampleStep above 1 builds it from a fraction of the pixels, every pixel is still matched to it after
+void GifMakePalette(const uint8_t* lastFrame, const uint8_t* nextFrame, uint32_t width, uint32_t height, int bitDepth, bool buildForDither, GifPalette* pPal, ThreadPool* pool, int sampleStep)
 {
     pPal->bitDepth = bitDepth;
 
+    if (sampleStep < 1)
+        sampleStep = 1;
+
     // SplitPalette is destructive (it sorts the pixels by color) so
     // we must create a copy of the image for it to destroy
-    size_t imageSize = (size_t)(width * height * 4 * sizeof(uint8_t));
+    // only the pixels the palette is built from are copied
+    int numPixels = (int)(width * height);
+    size_t imageSize = (size_t)((numPixels + sampleStep - 1) / sampleStep) * 4 * sizeof(uint8_t);
     uint8_t* destroyableImage = (uint8_t*)GIF_TEMP_MALLOC(imageSize);
-    memcpy(destroyableImage, nextFrame, imageSize);
 
-    int numPixels = (int)(width * height);
-    if (lastFrame)
-        numPixels = GifPickChangedPixels(lastFrame, destroyableImage, numPixels);
+    if (lastFrame || sampleStep > 1)
+    {
+        numPixels = GifSamplePixels(lastFrame, nextFrame, destroyableImage, numPixels, sampleStep);
+    }
+    else
+    {
+        memcpy(destroyableImage, nextFrame, imageSize);
+    }
 
-    GifSplitPalette(destroyableImage, numPixels, 1, 0, buildForDither, pPal);
+    GifSplitPalette(destroyableImage, numPixels, 1, 0, buildForDither, pPal, pool);
 
     GIF_TEMP_FREE(destroyableImage);
 
@@ -354,8 +401,51 @@ void GifMakePalette(const uint8_t* lastFrame, const uint8_t* nextFrame, uint32_t
     pPal->r[0] = pPal->g[0] = pPal->b[0] = 0;
 }
 
+// empty the cache, for a new palette
+void GifResetColorCache(GifColorCache* cache)
+{
+    memset(cache->key, 0, sizeof(cache->key));
+    cache->hits = 0;
+    cache->lookups = 0;
+}
+
+// GifGetClosestPaletteColor for a whole color, looked up in the cache first
+int GifGetCachedPaletteColor(GifPalette* pPal, GifColorCache* cache, int r, int g, int b)
+{
+    int32_t bestDiff = 1000000;
+    int32_t bestInd = 1;
+
+    // dithering can push a channel past 255, those colors don't fit in a key
+    if ((r | g | b) > 255)
+    {
+        GifGetClosestPaletteColor(pPal, r, g, b, &bestInd, &bestDiff, 1);
+        return bestInd;
+    }
+
+    uint32_t key = (((uint32_t)r << 16) | ((uint32_t)g << 8) | (uint32_t)b) + 1;
+
+    // multiplicative hash, the top bits pick the slot
+    uint32_t slot = (key * 2654435761u) >> (32 - kGifColorCacheBits);
+
+    ++cache->lookups;
+    if (cache->key[slot] == key)
+    {
+        ++cache->hits;
+        return cache->index[slot];
+    }
+
+    GifGetClosestPaletteColor(pPal, r, g, b, &bestInd, &bestDiff, 1);
+
+    // a clash just replaces the older color
+    cache->key[slot] = key;
+    cache->index[slot] = (uint8_t)bestInd;
+
+    return bestInd;
+}
+
 // Implements Floyd-Steinberg dithering, writes palette value to alpha
-void GifDitherImage(const uint8_t* lastFrame, const uint8_t* nextFrame, uint8_t* outFrame, uint32_t width, uint32_t height, GifPalette* pPal)
+// Given a cache, palette lookups go through it
+void GifDitherImage(const uint8_t* lastFrame, const uint8_t* nextFrame, uint8_t* outFrame, uint32_t width, uint32_t height, GifPalette* pPal, GifColorCache* cache)
 {
     int numPixels = (int)(width * height);
 
@@ -401,7 +491,10 @@ void GifDitherImage(const uint8_t* lastFrame, const uint8_t* nextFrame, uint8_t*
             int32_t bestInd = kGifTransIndex;
 
             // Search the palete
-            GifGetClosestPaletteColor(pPal, rr, gg, bb, &bestInd, &bestDiff, 1);
+            if (cache)
+                bestInd = GifGetCachedPaletteColor(pPal, cache, rr, gg, bb);
+            else
+                GifGetClosestPaletteColor(pPal, rr, gg, bb, &bestInd, &bestDiff, 1);
 
             // Write the result to the temp buffer
             int32_t r_err = nextPix[0] - (int32_t)(pPal->r[bestInd]) * 256;
@@ -464,7 +557,8 @@ void GifDitherImage(const uint8_t* lastFrame, const uint8_t* nextFrame, uint8_t*
 }
 
 // Picks palette colors for the image using simple thresholding, no dithering
-void GifThresholdImage(const uint8_t* lastFrame, const uint8_t* nextFrame, uint8_t* outFrame, uint32_t width, uint32_t height, GifPalette* pPal)
+// Given a cache, palette lookups go through it
+void GifThresholdImage(const uint8_t* lastFrame, const uint8_t* nextFrame, uint8_t* outFrame, uint32_t width, uint32_t height, GifPalette* pPal, GifColorCache* cache)
 {
     uint32_t numPixels = width * height;
     for (uint32_t ii = 0; ii < numPixels; ++ii)
@@ -486,7 +580,10 @@ void GifThresholdImage(const uint8_t* lastFrame, const uint8_t* nextFrame, uint8
             // palettize the pixel
             int32_t bestDiff = 1000000;
             int32_t bestInd = 1;
-            GifGetClosestPaletteColor(pPal, nextFrame[0], nextFrame[1], nextFrame[2], &bestInd, &bestDiff, 1);
+            if (cache)
+                bestInd = GifGetCachedPaletteColor(pPal, cache, nextFrame[0], nextFrame[1], nextFrame[2]);
+            else
+                GifGetClosestPaletteColor(pPal, nextFrame[0], nextFrame[1], nextFrame[2], &bestInd, &bestDiff, 1);
 
             // Write the resulting color to the output buffer
             outFrame[0] = pPal->r[bestInd];
@@ -547,11 +644,9 @@ void GifWriteCode(FILE* f, GifBitStatus* stat, uint32_t code, uint32_t length)
 // write a 256-color (8-bit) image palette to the file
 void GifWritePalette(const GifPalette* pPal, FILE* f)
 {
-    fputc(0, f);  // first color: transparency
-    fputc(0, f);
-    fputc(0, f);
-
-    for (int ii = 1; ii < (1 << pPal->bitDepth); ++ii)
+    // first color: transparency (GifMakePalette leaves it black), or a color for palettized
+    // frames with no transparency
+    for (int ii = 0; ii < (1 << pPal->bitDepth); ++ii)
     {
         uint32_t r = pPal->r[ii];
         uint32_t g = pPal->g[ii];
@@ -563,14 +658,15 @@ void GifWritePalette(const GifPalette* pPal, FILE* f)
     }
 }
 
-// write the image header, LZW-compress and write out the image
-void GifWriteLzwImage(FILE* f, uint8_t* image, uint32_t left, uint32_t top, uint32_t width, uint32_t height, uint32_t delay, GifPalette* pPal)
+// write the graphics control extension and image descriptor, followed by pPal as the
+// local color table (NULL to use the global one)
+void GifWriteImageHeader(FILE* f, uint32_t left, uint32_t top, uint32_t width, uint32_t height, uint32_t delay, const GifPalette* pPal, bool transparent)
 {
     // graphics control extension
     fputc(0x21, f);
     fputc(0xf9, f);
     fputc(0x04, f);
-    fputc(0x05, f); // leave prev frame in place, this frame has transparency
+    fputc(transparent ? 0x05 : 0x04, f); // leave prev frame in place, this frame has transparency (or not)
     fputc(delay & 0xff, f);
     fputc((delay >> 8) & 0xff, f);
     fputc(kGifTransIndex, f); // transparent color index
@@ -591,11 +687,23 @@ void GifWriteLzwImage(FILE* f, uint8_t* image, uint32_t left, uint32_t top, uint
     //fputc(0, f); // no local color table, no transparency
     //fputc(0x80, f); // no local color table, but transparency
 
-    fputc(0x80 + pPal->bitDepth - 1, f); // local color table present, 2 ^ bitDepth entries
-    GifWritePalette(pPal, f);
+    if (pPal)
+    {
+        fputc(0x80 + pPal->bitDepth - 1, f); // local color table present, 2 ^ bitDepth entries
+        GifWritePalette(pPal, f);
+    }
+    else
+    {
+        fputc(0, f); // no local color table, the global one is used
+    }
+}
 
-    const int minCodeSize = pPal->bitDepth;
-    const uint32_t clearCode = 1 << pPal->bitDepth;
+// The original encoder, a bit at a time through GifWriteCode with a 2MB dictionary per image.
+// Writes the same bytes as GifWriteLzwData, kept to compare it against
+void GifWriteLzwDataBitwise(FILE* f, const uint8_t* image, uint32_t stride, uint32_t width, uint32_t height, int bitDepth)
+{
+    const int minCodeSize = bitDepth;
+    const uint32_t clearCode = 1 << bitDepth;
 
     fputc(minCodeSize, f); // min code size 8 bits
 
@@ -619,10 +727,10 @@ void GifWriteLzwImage(FILE* f, uint8_t* image, uint32_t left, uint32_t top, uint
         {
 #ifdef GIF_FLIP_VERT
             // bottom-left origin image (such as an OpenGL capture)
-            uint8_t nextValue = image[((height - 1 - yy) * width + xx) * 4 + 3];
+            uint8_t nextValue = image[((height - 1 - yy) * width + xx) * stride];
 #else
             // top-left origin
-            uint8_t nextValue = image[(yy * width + xx) * 4 + 3];
+            uint8_t nextValue = image[(yy * width + xx) * stride];
 #endif
 
             // "worst possible mode" - no compression, every single code is followed immediately by a clear
@@ -669,7 +777,9 @@ void GifWriteLzwImage(FILE* f, uint8_t* image, uint32_t left, uint32_t top, uint
     }
 
     // compression footer
+    // the decoder adds an entry for the last code before it reads the clear, which can make it one bit wider
     GifWriteCode(f, &stat, (uint32_t)curCode, codeSize);
+    if (++maxCode >= (1ul << codeSize) && codeSize < 12) codeSize++;
     GifWriteCode(f, &stat, clearCode, codeSize);
     GifWriteCode(f, &stat, clearCode + 1, (uint32_t)minCodeSize + 1);
 
@@ -682,12 +792,410 @@ void GifWriteLzwImage(FILE* f, uint8_t* image, uint32_t left, uint32_t top, uint
     GIF_TEMP_FREE(codetree);
 }
 
-// Creates a gif file.
-// The input GIFWriter is assumed to be uninitialized.
-// The delay value is the time between frames in hundredths of a second - note that not all viewers pay much attention to this value.
-bool GifBegin(GifWriter* writer, const char* filename, uint32_t width, uint32_t height, uint32_t delay, int32_t bitDepth, bool dither)
+void GifLzwInit(GifLzwEncoder* enc)
+{
+    enc->data = NULL;
+    enc->size = 0;
+    enc->capacity = 0;
+    enc->codes = NULL;
+    enc->codesCapacity = 0;
+
+    // allocated by the first image encoded, so spare band encoders cost nothing until used
+    enc->dict = NULL;
+}
+
+void GifLzwFree(GifLzwEncoder* enc)
+{
+    GIF_FREE(enc->data);
+    GIF_FREE(enc->codes);
+    GIF_FREE(enc->dict);
+
+    enc->data = NULL;
+    enc->codes = NULL;
+    enc->dict = NULL;
+    enc->capacity = enc->codesCapacity = enc->size = 0;
+}
+
+// grow a buffer to hold at least needed bytes, its contents aren't kept
+static void GifReserve(uint8_t** buffer, size_t* capacity, size_t needed)
+{
+    if (*capacity >= needed) return;
+
+    GIF_FREE(*buffer);
+    *buffer = (uint8_t*)GIF_MALLOC(needed);
+    *capacity = needed;
+}
+
+// start a fresh dictionary
+static void GifLzwClear(GifLzwDictionary* dict)
+{
+    // the stamp sits in the top 12 bits of each key, wrapping around means really clearing
+    if (++dict->stamp >= 4096)
+    {
+        memset(dict->key, 0, sizeof(dict->key));
+        dict->stamp = 1;
+    }
+}
+
+// LZW-compress rows firstRow...firstRow + numRows - 1 of the image into enc->codes, returning
+// how many bits of codes there are. The first rows start with a clear code, the last ones end
+// with the end of information code; rows in between end with a clear code, so the rows after
+// them can be compressed on their own and their codes put straight after
+static uint64_t GifLzwEncodeRows(GifLzwEncoder* enc, const uint8_t* image, uint32_t stride, uint32_t width, uint32_t height,
+    uint32_t firstRow, uint32_t numRows, int bitDepth, bool first, bool last)
+{
+    (void)height; // Mute "Unused argument" warnings, only flipped images need it
+
+    const int minCodeSize = bitDepth;
+    const uint32_t clearCode = 1 << bitDepth;
+    const uint32_t slotMask = (1 << kGifLzwSlotBits) - 1;
+
+    // every pixel is at most one 12 bit code (plus the clears that come with them), and the
+    // accumulator stores whole 32 bit words, so the buffer never has to be checked mid-image
+    size_t numPixels = (size_t)width * numRows;
+    GifReserve(&enc->codes, &enc->codesCapacity, numPixels * 2 + 64);
+
+    if (!enc->dict)
+    {
+        enc->dict = (GifLzwDictionary*)GIF_MALLOC(sizeof(GifLzwDictionary));
+        memset(enc->dict, 0, sizeof(GifLzwDictionary));
+    }
+
+    GifLzwDictionary* dict = enc->dict;
+    GifLzwClear(dict);
+    uint32_t stamp = dict->stamp << 20;
+
+    uint8_t* out = enc->codes;
+    uint64_t bits = 0;     // codes not yet stored, lowest bit first
+    uint32_t numBits = 0;
+
+    uint32_t codeSize = (uint32_t)minCodeSize + 1;
+    uint32_t maxCode = clearCode + 1;
+    int32_t curCode = -1;
+
+    // add a code to the accumulator, storing a word once there is one
+#define GIF_LZW_EMIT(code, length) \
+    { \
+        bits |= (uint64_t)(code) << numBits; \
+        numBits += (length); \
+        if (numBits >= 32) \
+        { \
+            uint32_t word = (uint32_t)bits; \
+            memcpy(out, &word, 4); \
+            out += 4; \
+            bits >>= 32; \
+            numBits -= 32; \
+        } \
+    }
+
+    if (first)
+        GIF_LZW_EMIT(clearCode, codeSize);  // start with a fresh LZW dictionary
+
+    for (uint32_t yy = firstRow; yy < firstRow + numRows; ++yy)
+    {
+#ifdef GIF_FLIP_VERT
+        // bottom-left origin image (such as an OpenGL capture)
+        const uint8_t* row = image + (size_t)(height - 1 - yy) * width * stride;
+#else
+        // top-left origin
+        const uint8_t* row = image + (size_t)yy * width * stride;
+#endif
+
+        for (uint32_t xx = 0; xx < width; ++xx)
+        {
+            uint32_t nextValue = row[xx * stride];
+
+            if (curCode < 0)
+            {
+                // first value in a new run
+                curCode = (int32_t)nextValue;
+                continue;
+            }
+
+            // look the run up, linear probing from its hash
+            uint32_t key = stamp | ((uint32_t)curCode << 8) | nextValue;
+            uint32_t slot = (key * 2654435761u) >> (32 - kGifLzwSlotBits);
+            while (dict->key[slot] != key && (dict->key[slot] & 0xfff00000) == stamp)
+                slot = (slot + 1) & slotMask;
+
+            if (dict->key[slot] == key)
+            {
+                // current run already in the dictionary
+                curCode = dict->code[slot];
+                continue;
+            }
+
+            // finish the current run, write a code
+            GIF_LZW_EMIT(curCode, codeSize);
+
+            // insert the new run into the dictionary
+            dict->key[slot] = key;
+            dict->code[slot] = (uint16_t)++maxCode;
+
+            if (maxCode >= (1ul << codeSize))
+            {
+                // dictionary entry count has broken a size barrier,
+                // we need more bits for codes
+                codeSize++;
+            }
+            if (maxCode == 4095)
+            {
+                // the dictionary is full, clear it out and begin anew
+                GIF_LZW_EMIT(clearCode, codeSize); // clear tree
+
+                GifLzwClear(dict);
+                stamp = dict->stamp << 20;
+                codeSize = (uint32_t)(minCodeSize + 1);
+                maxCode = clearCode + 1;
+            }
+
+            curCode = (int32_t)nextValue;
+        }
+    }
+
+    // compression footer (the clear alone between rows)
+    // the decoder adds an entry for the last code before it reads the clear, so the clear has to
+    // be written at the width that entry takes it to, or the rows after it can't be read
+    GIF_LZW_EMIT(curCode, codeSize);
+    if (++maxCode >= (1ul << codeSize) && codeSize < 12)
+        codeSize++;
+    GIF_LZW_EMIT(clearCode, codeSize);
+    if (last)
+        GIF_LZW_EMIT(clearCode + 1, (uint32_t)minCodeSize + 1);
+
+#undef GIF_LZW_EMIT
+
+    // the last partial word, padded out to a whole byte with zero bits
+    uint64_t totalBits = (uint64_t)(out - enc->codes) * 8 + numBits;
+    while (numBits > 0)
+    {
+        *out++ = (uint8_t)bits;
+        bits >>= 8;
+        numBits = numBits > 8 ? numBits - 8 : 0;
+    }
+
+    return totalBits;
+}
+
+// split enc->codes into sub-blocks of up to 255 bytes, each after its length, in enc->data
+static void GifLzwSubBlocks(GifLzwEncoder* enc, uint64_t numBits, int minCodeSize)
+{
+    size_t numCodeBytes = (size_t)((numBits + 7) / 8);
+    GifReserve(&enc->data, &enc->capacity, numCodeBytes + numCodeBytes / 255 + 3);
+
+    uint8_t* data = enc->data;
+    *data++ = (uint8_t)minCodeSize; // min code size 8 bits
+
+    for (size_t start = 0; start < numCodeBytes; start += 255)
+    {
+        size_t blockSize = numCodeBytes - start < 255 ? numCodeBytes - start : 255;
+        *data++ = (uint8_t)blockSize;
+        memcpy(data, enc->codes + start, blockSize);
+        data += blockSize;
+    }
+
+    *data++ = 0; // image block terminator
+    enc->size = (size_t)(data - enc->data);
+}
+
+// LZW-compress one palette index every stride bytes of image into enc->data
+// Codes are packed into a 64 bit accumulator and stored 32 bits at a time
+void GifLzwEncode(GifLzwEncoder* enc, const uint8_t* image, uint32_t stride, uint32_t width, uint32_t height, int bitDepth)
+{
+    uint64_t numBits = GifLzwEncodeRows(enc, image, stride, width, height, 0, height, bitDepth, true, true);
+    GifLzwSubBlocks(enc, numBits, bitDepth);
+}
+
+// put srcBits bits of src straight after the first destBits bits of dest
+// bits past the end of src's last byte are zero, and dest has a byte spare past the end
+static void GifAppendBits(uint8_t* dest, uint64_t destBits, const uint8_t* src, uint64_t srcBits)
+{
+    uint8_t* out = dest + destBits / 8;
+    uint32_t shift = (uint32_t)(destBits & 7);
+    size_t srcBytes = (size_t)((srcBits + 7) / 8);
+
+    if (shift == 0)
+    {
+        memcpy(out, src, srcBytes);
+        return;
+    }
+
+    // out[0] already holds shift bits
+    for (size_t ii = 0; ii < srcBytes; ++ii)
+    {
+        out[ii] = (uint8_t)(out[ii] | (src[ii] << shift));
+        out[ii + 1] = (uint8_t)(src[ii] >> (8 - shift));
+    }
+}
+
+// GifLzwEncode with the rows split into numBands bands that are compressed side by side on the pool,
+// the first into enc and the rest into bandEncs[0...numBands - 2]. Each band starts a fresh dictionary
+void GifLzwEncodeBands(GifLzwEncoder* enc, GifLzwEncoder* bandEncs, int numBands, ThreadPool* pool,
+    const uint8_t* image, uint32_t stride, uint32_t width, uint32_t height, int bitDepth)
+{
+    if (numBands > kGifMaxBands) numBands = kGifMaxBands;
+    if (numBands > (int)height) numBands = (int)height;
+
+    if (!pool || numBands < 2)
+    {
+        GifLzwEncode(enc, image, stride, width, height, bitDepth);
+        return;
+    }
+
+    // the first band is compressed into enc, which then takes every band's codes
+    GifReserve(&enc->codes, &enc->codesCapacity, (size_t)width * height * 2 + 64 * numBands);
+
+    // whole rows to a band, which can leave fewer bands
+    uint32_t rowsPerBand = (height + numBands - 1) / numBands;
+    numBands = (int)((height + rowsPerBand - 1) / rowsPerBand);
+
+    uint64_t bandBits[kGifMaxBands];
+    {
+        TaskGroup tasks(*pool);
+        for (int band = 1; band < numBands; ++band)
+        {
+            uint32_t firstRow = band * rowsPerBand;
+            uint32_t numRows = GifIMin((int)rowsPerBand, (int)(height - firstRow));
+            tasks.Run([=, &bandBits] { bandBits[band] = GifLzwEncodeRows(&bandEncs[band - 1], image, stride, width, height, firstRow, numRows, bitDepth, false, band == numBands - 1); });
+        }
+
+        bandBits[0] = GifLzwEncodeRows(enc, image, stride, width, height, 0, rowsPerBand, bitDepth, true, false);
+        tasks.Wait();
+    }
+
+    // every band ends on a clear code, so the next band's codes follow on straight after
+    uint64_t numBits = bandBits[0];
+    for (int band = 1; band < numBands; ++band)
+    {
+        GifAppendBits(enc->codes, numBits, bandEncs[band - 1].codes, bandBits[band]);
+        numBits += bandBits[band];
+    }
+
+    GifLzwSubBlocks(enc, numBits, bitDepth);
+}
+
+// decode image data as GifLzwEncode writes it (min code size, then the sub-blocks) into
+// numPixels palette indices, the way a decoder reading the file would
+// returns false unless exactly numPixels indices came out before the end of information code
+bool GifLzwDecode(const uint8_t* data, size_t size, uint8_t* indices, size_t numPixels)
+{
+    if (size < 2) return false;
+
+    const int minCodeSize = data[0];
+    if (minCodeSize < 1 || minCodeSize > 8) return false;
+    const uint32_t clearCode = 1 << minCodeSize;
+
+    // each code's entry is its prefix code and last value, plus the first value and length of the run
+    uint16_t* prefix = (uint16_t*)GIF_TEMP_MALLOC(4096 * sizeof(uint16_t));
+    uint8_t* suffix = (uint8_t*)GIF_TEMP_MALLOC(4096);
+    uint8_t* firstValue = (uint8_t*)GIF_TEMP_MALLOC(4096);
+    uint16_t* length = (uint16_t*)GIF_TEMP_MALLOC(4096 * sizeof(uint16_t));
+
+    for (uint32_t ii = 0; ii < clearCode; ++ii)
+    {
+        suffix[ii] = firstValue[ii] = (uint8_t)ii;
+        length[ii] = 1;
+    }
+
+    size_t pos = 1;
+    size_t blockLeft = 0;
+    uint32_t bits = 0, numBits = 0;
+    uint32_t codeSize = (uint32_t)minCodeSize + 1;
+    uint32_t nextCode = clearCode + 2;
+    int32_t lastCode = -1;
+    size_t written = 0;
+    bool ended = false;
+
+    while (!ended)
+    {
+        // fill up with whole bytes from the sub-blocks
+        while (numBits < codeSize)
+        {
+            if (blockLeft == 0)
+            {
+                if (pos >= size || data[pos] == 0) break;
+                blockLeft = data[pos++];
+            }
+            if (pos >= size) break;
+            bits |= (uint32_t)data[pos++] << numBits;
+            numBits += 8;
+            --blockLeft;
+        }
+        if (numBits < codeSize) break;
+
+        uint32_t code = bits & ((1u << codeSize) - 1);
+        bits >>= codeSize;
+        numBits -= codeSize;
+
+        if (code == clearCode)
+        {
+            codeSize = (uint32_t)minCodeSize + 1;
+            nextCode = clearCode + 2;
+            lastCode = -1;
+            continue;
+        }
+        if (code == clearCode + 1)
+        {
+            ended = true;
+            break;
+        }
+
+        // a code can only be one already in the dictionary, or the one about to be added
+        if (code > nextCode || (lastCode < 0 && code >= clearCode) || (code == nextCode && nextCode >= 4096)) break;
+
+        if (lastCode >= 0 && nextCode < 4096)
+        {
+            prefix[nextCode] = (uint16_t)lastCode;
+            firstValue[nextCode] = firstValue[lastCode];
+            suffix[nextCode] = code == nextCode ? firstValue[lastCode] : firstValue[code];
+            length[nextCode] = (uint16_t)(length[lastCode] + 1);
+            ++nextCode;
+        }
+
+        // the next code is read one bit wider once the dictionary is about to outgrow this width
+        if (nextCode >= (1u << codeSize) && codeSize < 12)
+            codeSize++;
+
+        // write the run out back to front
+        if (written + length[code] > numPixels) break;
+        written += length[code];
+        uint32_t run = code;
+        for (size_t ii = written; ii-- > written - length[code]; )
+        {
+            indices[ii] = suffix[run];
+            run = prefix[run];
+        }
+
+        lastCode = (int32_t)code;
+    }
+
+    GIF_TEMP_FREE(length);
+    GIF_TEMP_FREE(firstValue);
+    GIF_TEMP_FREE(suffix);
+    GIF_TEMP_FREE(prefix);
+
+    return ended && written == numPixels;
+}
+
+// LZW-compress and write out the image data, one palette index every stride bytes of image
+void GifWriteLzwData(FILE* f, GifLzwEncoder* enc, const uint8_t* image, uint32_t stride, uint32_t width, uint32_t height, int bitDepth)
+{
+    GifLzwEncode(enc, image, stride, width, height, bitDepth);
+    fwrite(enc->data, 1, enc->size, f);
+}
+
+// write the image header, LZW-compress and write out the image
+void GifWriteLzwImage(FILE* f, GifLzwEncoder* enc, uint8_t* image, uint32_t left, uint32_t top, uint32_t width, uint32_t height, uint32_t delay, GifPalette* pPal)
+{
+    GifWriteImageHeader(f, left, top, width, height, delay, pPal, true);
+
+    // the palette index is in the alpha byte
+    GifWriteLzwData(f, enc, image + 3, 4, width, height, pPal->bitDepth);
+}
+
+// Opens the file and writes the header, with a black global color table of 2 ^ globalBits entries
+static bool GifBeginFile(GifWriter* writer, const char* filename, uint32_t width, uint32_t height, uint32_t delay, int globalBits)
 {
-    (void)bitDepth; (void)dither; // Mute "Unused argument" warnings
 #if defined(_MSC_VER) && (_MSC_VER >= 1400)
     writer->f = 0;
     fopen_s(&writer->f, filename, "wb");
@@ -697,9 +1205,20 @@ bool GifBegin(GifWriter* writer, const char* filename, uint32_t width, uint32_t
     if (!writer->f) return false;
 
     writer->firstFrame = true;
+    writer->cacheHits = 0;
+    writer->cacheLookups = 0;
+    writer->paletteStep = 1;
+    writer->pool = NULL;
+    writer->globalPal = NULL;
+    writer->lastPal = NULL;
 
     // allocate
     writer->oldImage = (uint8_t*)GIF_MALLOC(width * height * 4);
+    GifLzwInit(&writer->lzw);
+
+    writer->lzwBands = 1;
+    for (int ii = 0; ii < kGifMaxBands - 1; ++ii)
+        GifLzwInit(&writer->bandLzw[ii]);
 
     fputs("GIF89a", writer->f);
 
@@ -709,19 +1228,13 @@ bool GifBegin(GifWriter* writer, const char* filename, uint32_t width, uint32_t
     fputc(height & 0xff, writer->f);
     fputc((height >> 8) & 0xff, writer->f);
 
-    fputc(0xf0, writer->f);  // there is an unsorted global color table of 2 entries
+    fputc(0xf0 + globalBits - 1, writer->f);  // there is an unsorted global color table of 2 ^ globalBits entries
     fputc(0, writer->f);     // background color
     fputc(0, writer->f);     // pixels are square (we need to specify this because it's 1989)
 
-    // now the "global" palette (really just a dummy palette)
-    // color 0: black
-    fputc(0, writer->f);
-    fputc(0, writer->f);
-    fputc(0, writer->f);
-    // color 1: also black
-    fputc(0, writer->f);
-    fputc(0, writer->f);
-    fputc(0, writer->f);
+    // now the "global" palette (just black until something fills it in)
+    for (int ii = 0; ii < (1 << globalBits) * 3; ++ii)
+        fputc(0, writer->f);
 
     if (delay != 0)
     {
@@ -742,6 +1255,38 @@ bool GifBegin(GifWriter* writer, const char* filename, uint32_t width, uint32_t
     return true;
 }
 
+// Creates a gif file.
+// The input GIFWriter is assumed to be uninitialized.
+// The delay value is the time between frames in hundredths of a second - note that not all viewers pay much attention to this value.
+bool GifBegin(GifWriter* writer, const char* filename, uint32_t width, uint32_t height, uint32_t delay, int32_t bitDepth, bool dither)
+{
+    (void)bitDepth; (void)dither; // Mute "Unused argument" warnings
+
+    // the global palette is really just a dummy palette, every frame brings its own
+    return GifBeginFile(writer, filename, width, height, delay, 1);
+}
+
+// Creates a gif file for frames that are already palettized (GifWriteIndexedFrame).
+// The first frame's palette becomes the global color table.
+bool GifBeginIndexed(GifWriter* writer, const char* filename, uint32_t width, uint32_t height, uint32_t delay)
+{
+    // room for a full 256 color table, filled in by the first frame
+    if (!GifBeginFile(writer, filename, width, height, delay, 8)) return false;
+
+    writer->globalPal = (GifPalette*)GIF_MALLOC(sizeof(GifPalette));
+    writer->lastPal = (GifPalette*)GIF_MALLOC(sizeof(GifPalette));
+
+    return true;
+}
+
+// LZW-compress and write out a frame's image data, in writer->lzwBands bands side by side
+// when the writer has a pool
+static void GifWriteFrameData(GifWriter* writer, const uint8_t* image, uint32_t stride, uint32_t width, uint32_t height, int bitDepth)
+{
+    GifLzwEncodeBands(&writer->lzw, writer->bandLzw, writer->lzwBands, writer->pool, image, stride, width, height, bitDepth);
+    fwrite(writer->lzw.data, 1, writer->lzw.size, writer->f);
+}
+
 // Writes out a new frame to a GIF in progress.
 // The GIFWriter should have been created by GIFBegin.
 // AFAIK, it is legal to use different bit depths for different frames of an image -
@@ -754,14 +1299,83 @@ bool GifWriteFrame(GifWriter* writer, const uint8_t* image, uint32_t width, uint
     writer->firstFrame = false;
 
     GifPalette pal;
-    GifMakePalette((dither ? NULL : oldImage), image, width, height, bitDepth, dither, &pal);
+    GifMakePalette((dither ? NULL : oldImage), image, width, height, bitDepth, dither, &pal, writer->pool, writer->paletteStep);
+
+    // fractal frames only have a few hundred colors, so most lookups are repeats
+    GifColorCache* cache = (GifColorCache*)GIF_TEMP_MALLOC(sizeof(GifColorCache));
+    GifResetColorCache(cache);
 
     if (dither)
-        GifDitherImage(oldImage, image, writer->oldImage, width, height, &pal);
+        GifDitherImage(oldImage, image, writer->oldImage, width, height, &pal, cache);
     else
-        GifThresholdImage(oldImage, image, writer->oldImage, width, height, &pal);
+        GifThresholdImage(oldImage, image, writer->oldImage, width, height, &pal, cache);
+
+    writer->cacheHits += cache->hits;
+    writer->cacheLookups += cache->lookups;
+    GIF_TEMP_FREE(cache);
+
+    GifWriteImageHeader(writer->f, 0, 0, width, height, delay, &pal, true);
+
+    // the palette index is in the alpha byte
+    GifWriteFrameData(writer, writer->oldImage + 3, 4, width, height, pal.bitDepth);
+
+    return true;
+}
+
+// whether two palettes hold the same colors
+static bool GifSamePalette(const GifPalette* pA, const GifPalette* pB)
+{
+    return pA->bitDepth == pB->bitDepth &&
+        memcmp(pA->r, pB->r, sizeof(pA->r)) == 0 &&
+        memcmp(pA->g, pB->g, sizeof(pA->g)) == 0 &&
+        memcmp(pA->b, pB->b, sizeof(pA->b)) == 0;
+}
+
+// Writes out a frame that is already palettized, one index into pPal per pixel.
+// The GIFWriter should have been created by GifBeginIndexed.
+// If transparent, entry 0 of pPal is the transparent color and pixels that didn't change are
+// written as it when the last frame had the same palette. Otherwise every entry is a color and
+// the whole frame is written. Frames with a palette other than the first frame's carry it as a
+// local color table.
+bool GifWriteIndexedFrame(GifWriter* writer, const uint8_t* indices, uint32_t width, uint32_t height, uint32_t delay, const GifPalette* pPal, bool transparent)
+{
+    if (!writer->f || !writer->globalPal) return false;
+
+    uint32_t numPixels = width * height;
+
+    // the last frame's indices, then the frame as it's written out
+    uint8_t* lastIndices = writer->oldImage;
+    uint8_t* outIndices = writer->oldImage + numPixels;
+
+    bool delta = transparent && !writer->firstFrame && GifSamePalette(writer->lastPal, pPal);
+
+    if (writer->firstFrame)
+    {
+        // fill in the global color table GifBeginIndexed left room for
+        *writer->globalPal = *pPal;
+
+        long end = ftell(writer->f);
+        fseek(writer->f, 13, SEEK_SET);
+        GifWritePalette(pPal, writer->f);
+        fseek(writer->f, end, SEEK_SET);
+
+        writer->firstFrame = false;
+    }
+
+    const uint8_t* image = indices;
+    if (delta)
+    {
+        for (uint32_t ii = 0; ii < numPixels; ++ii)
+            outIndices[ii] = indices[ii] == lastIndices[ii] ? (uint8_t)kGifTransIndex : indices[ii];
+
+        image = outIndices;
+    }
 
-    GifWriteLzwImage(writer->f, writer->oldImage, 0, 0, width, height, delay, &pal);
+    GifWriteImageHeader(writer->f, 0, 0, width, height, delay, GifSamePalette(writer->globalPal, pPal) ? NULL : pPal, transparent);
+    GifWriteFrameData(writer, image, 1, width, height, pPal->bitDepth);
+
+    memcpy(lastIndices, indices, numPixels);
+    *writer->lastPal = *pPal;
 
     return true;
 }
@@ -776,9 +1390,20 @@ bool GifEnd(GifWriter* writer)
     fputc(0x3b, writer->f); // end of file
     fclose(writer->f);
     GIF_FREE(writer->oldImage);
+    GifLzwFree(&writer->lzw);
+    for (int ii = 0; ii < kGifMaxBands - 1; ++ii)
+        GifLzwFree(&writer->bandLzw[ii]);
+
+    if (writer->globalPal)
+    {
+        GIF_FREE(writer->globalPal);
+        GIF_FREE(writer->lastPal);
+    }
 
     writer->f = NULL;
     writer->oldImage = NULL;
+    writer->globalPal = NULL;
+    writer->lastPal = NULL;
 
     return true;
 }
\ No newline at end of file
@@ -39,6 +39,9 @@
 // MALLOC and FREE are used only by GifBegin and GifEnd respectively (to allocate a buffer the size of the image, which
 // is used to find changed pixels for delta-encoding.)
 
+// The palette's k-d tree is split on this pool when the writer is given one
+class ThreadPool;
+
 #ifndef GIF_TEMP_MALLOC
 #include <stdlib.h>
 #define GIF_TEMP_MALLOC malloc
@@ -98,8 +101,12 @@ void GifPartitionByMedian(uint8_t* image, int left, int right, int com, int need
 // Just partition around a given pivot, returning the split point
 int GifPartitionByMean(uint8_t* image, int left, int right, int com, int neededMean);
 
+// per-channel min and max of a run of pixels, four pixels at a time
+void GifMinMax(const uint8_t* image, int numPixels, int* minRGB, int* maxRGB);
+
 // Builds a palette by creating a balanced k-d tree of all pixels in the image
-void GifSplitPalette(uint8_t* image, int numPixels, int treeNode, int treeLevel, bool buildForDither, GifPalette* pal);
+// Given a pool, the two halves of each large enough node are split at the same time
+void GifSplitPalette(uint8_t* image, int numPixels, int treeNode, int treeLevel, bool buildForDither, GifPalette* pal, ThreadPool* pool = NULL);
 
 // Finds all pixels that have changed from the previous image and
 // moves them to the fromt of th buffer.
@@ -107,15 +114,41 @@ void GifSplitPalette(uint8_t* image, int numPixels, int treeNode, int treeLevel,
 // changed pixels only.
 int GifPickChangedPixels(const uint8_t* lastFrame, uint8_t* frame, int numPixels);
 
+// Copies every sampleStep-th pixel (of the changed ones, given a last frame) to the front of
+// outFrame, in one pass over the frame
+int GifSamplePixels(const uint8_t* lastFrame, const uint8_t* frame, uint8_t* outFrame, int numPixels, int sampleStep);
+
 // Creates a palette by placing all the image pixels in a k-d tree and then averaging the blocks at the bottom.
 // This is known as the "median split" technique
-void GifMakePalette(const uint8_t* lastFrame, const uint8_t* nextFrame, uint32_t width, uint32_t height, int bitDepth, bool buildForDither, GifPalette* pPal);
+// A sampleStep above 1 builds it from a fraction of the pixels, every pixel is still matched to it after
+void GifMakePalette(const uint8_t* lastFrame, const uint8_t* nextFrame, uint32_t width, uint32_t height, int bitDepth, bool buildForDither, GifPalette* pPal, ThreadPool* pool = NULL, int sampleStep = 1);
+
+// Remembers the palette entry picked for each exact color, direct mapped, so a color seen
+// before skips the k-d tree walk. Only good for the palette it was filled against.
+const int kGifColorCacheBits = 12;
+
+typedef struct
+{
+    uint32_t key[1 << kGifColorCacheBits];    // color + 1, 0 for an empty slot
+    uint8_t index[1 << kGifColorCacheBits];
+
+    uint32_t hits;
+    uint32_t lookups;
+} GifColorCache;
+
+// empty the cache, for a new palette
+void GifResetColorCache(GifColorCache* cache);
+
+// GifGetClosestPaletteColor for a whole color, looked up in the cache first
+int GifGetCachedPaletteColor(GifPalette* pPal, GifColorCache* cache, int r, int g, int b);
 
 // Implements Floyd-Steinberg dithering, writes palette value to alpha
-void GifDitherImage(const uint8_t* lastFrame, const uint8_t* nextFrame, uint8_t* outFrame, uint32_t width, uint32_t height, GifPalette* pPal);
+// Given a cache, palette lookups go through it
+void GifDitherImage(const uint8_t* lastFrame, const uint8_t* nextFrame, uint8_t* outFrame, uint32_t width, uint32_t height, GifPalette* pPal, GifColorCache* cache = NULL);
 
 // Picks palette colors for the image using simple thresholding, no dithering
-void GifThresholdImage(const uint8_t* lastFrame, const uint8_t* nextFrame, uint8_t* outFrame, uint32_t width, uint32_t height, GifPalette* pPal);
+// Given a cache, palette lookups go through it
+void GifThresholdImage(const uint8_t* lastFrame, const uint8_t* nextFrame, uint8_t* outFrame, uint32_t width, uint32_t height, GifPalette* pPal, GifColorCache* cache = NULL);
 
 // Simple structure to write out the LZW-compressed portion of the image
 // one bit at a time
@@ -148,8 +181,62 @@ typedef struct
 // write a 256-color (8-bit) image palette to the file
 void GifWritePalette(const GifPalette* pPal, FILE* f);
 
+// write the graphics control extension and image descriptor, followed by pPal as the
+// local color table (NULL to use the global one)
+void GifWriteImageHeader(FILE* f, uint32_t left, uint32_t top, uint32_t width, uint32_t height, uint32_t delay, const GifPalette* pPal, bool transparent);
+
+// The LZW dictionary as a hash table from (run code, next index) to the run's code.
+// Entries are stamped with the dictionary they belong to, so clearing it is just a new stamp.
+const int kGifLzwSlotBits = 13;
+
+typedef struct
+{
+    uint32_t key[1 << kGifLzwSlotBits];    // stamp << 20 | run code << 8 | next index
+    uint16_t code[1 << kGifLzwSlotBits];
+    uint32_t stamp;                         // 1...4095, an entry from an older stamp is an empty slot
+} GifLzwDictionary;
+
+// Buffers and dictionary kept from one image to the next, so encoding doesn't allocate
+typedef struct
+{
+    uint8_t* data;         // the compressed image: min code size, data sub-blocks and terminator
+    size_t size;
+    size_t capacity;
+
+    uint8_t* codes;        // the packed codes before they're split into sub-blocks
+    size_t codesCapacity;
+
+    GifLzwDictionary* dict;
+} GifLzwEncoder;
+
+void GifLzwInit(GifLzwEncoder* enc);
+void GifLzwFree(GifLzwEncoder* enc);
+
+// LZW-compress one palette index every stride bytes of image into enc->data
+// Codes are packed into a 64 bit accumulator and stored 32 bits at a time
+void GifLzwEncode(GifLzwEncoder* enc, const uint8_t* image, uint32_t stride, uint32_t width, uint32_t height, int bitDepth);
+
+// The most bands GifLzwEncodeBands splits an image into
+const int kGifMaxBands = 16;
+
+// GifLzwEncode with the rows split into numBands bands that are compressed side by side on the pool,
+// the first into enc and the rest into bandEncs[0...numBands - 2]. Each band starts a fresh dictionary
+void GifLzwEncodeBands(GifLzwEncoder* enc, GifLzwEncoder* bandEncs, int numBands, ThreadPool* pool,
+    const uint8_t* image, uint32_t stride, uint32_t width, uint32_t height, int bitDepth);
+
+// Decode image data as GifLzwEncode writes it (min code size, then the sub-blocks) into
+// numPixels palette indices, false unless exactly numPixels indices came out
+bool GifLzwDecode(const uint8_t* data, size_t size, uint8_t* indices, size_t numPixels);
+
+// LZW-compress and write out the image data, one palette index every stride bytes of image
+void GifWriteLzwData(FILE* f, GifLzwEncoder* enc, const uint8_t* image, uint32_t stride, uint32_t width, uint32_t height, int bitDepth);
+
+// The original encoder, a bit at a time through GifWriteCode with a 2MB dictionary per image.
+// Writes the same bytes as GifWriteLzwData, kept to compare it against
+void GifWriteLzwDataBitwise(FILE* f, const uint8_t* image, uint32_t stride, uint32_t width, uint32_t height, int bitDepth);
+
 // write the image header, LZW-compress and write out the image
-void GifWriteLzwImage(FILE* f, uint8_t* image, uint32_t left, uint32_t top, uint32_t width, uint32_t height, uint32_t delay, GifPalette* pPal);
+void GifWriteLzwImage(FILE* f, GifLzwEncoder* enc, uint8_t* image, uint32_t left, uint32_t top, uint32_t width, uint32_t height, uint32_t delay, GifPalette* pPal);
 
 typedef struct
 {
@@ -157,7 +244,21 @@ typedef struct
     uint8_t* oldImage;
     bool firstFrame;
 
-    uint8_t padding[7];    // make padding explicit
+    uint8_t padding[3];    // make padding explicit
+
+    uint64_t cacheHits;    // palette lookups answered by the color cache, over every frame so far
+    uint64_t cacheLookups;
+
+    int paletteStep;       // build each palette from every paletteStep-th pixel, 1 by GifBegin
+    ThreadPool* pool;      // split palettes on this pool, NULL (by GifBegin) for one thread
+
+    GifPalette* globalPal; // palettized frames only (GifBeginIndexed), the global color table
+    GifPalette* lastPal;   // and the last frame's palette
+
+    GifLzwEncoder lzw;
+
+    int lzwBands;          // compress each frame in this many bands on the pool, 1 by GifBegin
+    GifLzwEncoder bandLzw[kGifMaxBands - 1];
 } GifWriter;
 
 // Creates a gif file.
@@ -171,6 +272,18 @@ bool GifBegin(GifWriter* writer, const char* filename, uint32_t width, uint32_t
 // this may be handy to save bits in animations that don't change much.
 bool GifWriteFrame(GifWriter* writer, const uint8_t* image, uint32_t width, uint32_t height, uint32_t delay, int bitDepth = 8, bool dither = false);
 
+// Creates a gif file for frames that are already palettized (GifWriteIndexedFrame).
+// The first frame's palette becomes the global color table.
+bool GifBeginIndexed(GifWriter* writer, const char* filename, uint32_t width, uint32_t height, uint32_t delay);
+
+// Writes out a frame that is already palettized, one index into pPal per pixel.
+// The GIFWriter should have been created by GifBeginIndexed.
+// If transparent, entry 0 of pPal is the transparent color and pixels that didn't change are
+// written as it when the last frame had the same palette. Otherwise every entry is a color and
+// the whole frame is written. Frames with a palette other than the first frame's carry it as a
+// local color table.
+bool GifWriteIndexedFrame(GifWriter* writer, const uint8_t* indices, uint32_t width, uint32_t height, uint32_t delay, const GifPalette* pPal, bool transparent);
+
 // Writes the EOF code, closes the file handle, and frees temp memory used by a GIF.
 // Many if not most viewers will still display a GIF properly if the EOF code is missing,
 // but it's still a good idea to write it out.
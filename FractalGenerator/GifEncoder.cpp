@@ -0,0 +1,260 @@
+/*********************************************************************************************
+**
+**	File Name:		GifEncoder.cpp
+**	Description:	This is the file that contains the function definitions for the gif
+**                  encoding thread
+**
+**	Author:			Clarke Needles
+**	Created:		10/17/2026
+**
+**********************************************************************************************/
+
+#include "GifEncoder.h"
+
+GifEncoder::GifEncoder(ThreadPool& pool)
+    : m_pool(pool)
+{
+    QueryPerformanceFrequency(&m_frequency);
+}
+
+GifEncoder::~GifEncoder()
+{
+    End();
+}
+
+bool GifEncoder::Begin(const char* filename, int width, int height, int delay, int capacity, bool indexed)
+{
+    End();
+
+    if (!(indexed ? GifBeginIndexed(&m_writer, filename, width, height, delay) : GifBegin(&m_writer, filename, width, height, delay)))
+    {
+        return false;
+    }
+    m_writer.pool = &m_pool;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_width = width;
+    m_height = height;
+    m_delay = delay;
+    m_capacity = capacity > 0 ? capacity : 1;
+    m_stop = false;
+    m_recording = true;
+    m_indexed = indexed;
+    m_encoded = m_dropped = 0;
+    m_lastEncodeTicks = m_totalEncodeTicks = m_totalLatencyTicks = 0;
+    m_cacheHits = m_cacheLookups = 0;
+
+    m_thread = std::thread(&GifEncoder::Loop, this);
+    return true;
+}
+
+void GifEncoder::Loop()
+{
+    while (true)
+    {
+        QueuedFrame frame;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_queueCondition.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+
+            // Stopping still writes out everything that was queued
+            if (m_queue.empty())
+            {
+                return;
+            }
+
+            frame = std::move(m_queue.front());
+            m_queue.pop_front();
+
+            m_writer.paletteStep = m_paletteStep;
+            m_writer.lzwBands = m_bands;
+        }
+        m_spaceCondition.notify_one();
+
+        // Palette, thresholding and LZW (only LZW for indexed frames), all off the render and UI threads
+        LARGE_INTEGER start, end;
+        QueryPerformanceCounter(&start);
+        if (m_indexed)
+        {
+            GifWriteIndexedFrame(&m_writer, frame.indices.data(), m_width, m_height, m_delay, &frame.palette, frame.transparent);
+        }
+        else
+        {
+            GifWriteFrame(&m_writer, reinterpret_cast<const uint8_t*>(frame.pixels.data()), m_width, m_height, m_delay);
+        }
+        QueryPerformanceCounter(&end);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_encoded;
+            m_lastEncodeTicks = end.QuadPart - start.QuadPart;
+            m_totalEncodeTicks += m_lastEncodeTicks;
+            m_totalLatencyTicks += end.QuadPart - frame.pushed.QuadPart;
+            m_cacheHits = m_writer.cacheHits;
+            m_cacheLookups = m_writer.cacheLookups;
+            m_spare.push_back(std::move(frame));
+        }
+    }
+}
+
+bool GifEncoder::MakeRoom(std::unique_lock<std::mutex>& lock)
+{
+    if (!m_recording)
+    {
+        return false;
+    }
+
+    if (m_queue.size() >= m_capacity)
+    {
+        if (m_policy == Policy::DROP)
+        {
+            ++m_dropped;
+            return false;
+        }
+
+        // Woken early if the policy changes to dropping, or the recording stops
+        m_spaceCondition.wait(lock, [this] { return m_queue.size() < m_capacity || m_policy == Policy::DROP || !m_recording; });
+        if (!m_recording)
+        {
+            return false;
+        }
+
+        if (m_queue.size() >= m_capacity)
+        {
+            ++m_dropped;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+GifEncoder::QueuedFrame GifEncoder::TakeSpare()
+{
+    QueuedFrame frame;
+    if (!m_spare.empty())
+    {
+        frame = std::move(m_spare.back());
+        m_spare.pop_back();
+    }
+
+    return frame;
+}
+
+void GifEncoder::Queue(QueuedFrame&& frame, std::unique_lock<std::mutex>& lock)
+{
+    QueryPerformanceCounter(&frame.pushed);
+    m_queue.push_back(std::move(frame));
+
+    lock.unlock();
+    m_queueCondition.notify_one();
+}
+
+bool GifEncoder::Push(const Colour* pixels)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_indexed || !MakeRoom(lock))
+    {
+        return false;
+    }
+
+    // The caller's buffer goes back to being rendered into, so the queue keeps its own copy
+    QueuedFrame frame = TakeSpare();
+    frame.pixels.assign(pixels, pixels + m_width * m_height);
+    Queue(std::move(frame), lock);
+
+    return true;
+}
+
+bool GifEncoder::PushIndexed(const uint8_t* indices, const GifPalette& palette, bool transparent)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_indexed || !MakeRoom(lock))
+    {
+        return false;
+    }
+
+    // A byte a pixel, a quarter of the copy Push makes
+    QueuedFrame frame = TakeSpare();
+    frame.indices.assign(indices, indices + m_width * m_height);
+    frame.palette = palette;
+    frame.transparent = transparent;
+    Queue(std::move(frame), lock);
+
+    return true;
+}
+
+void GifEncoder::End()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_recording)
+        {
+            return;
+        }
+
+        m_recording = false;
+        m_stop = true;
+    }
+    m_queueCondition.notify_one();
+    m_spaceCondition.notify_all();
+
+    m_thread.join();
+    GifEnd(&m_writer);
+
+    m_queue.clear();
+    m_spare.clear();
+}
+
+bool GifEncoder::IsRecording()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_recording;
+}
+
+bool GifEncoder::IsIndexed()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_indexed;
+}
+
+void GifEncoder::SetPolicy(Policy policy)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_policy = policy;
+    }
+
+    // A waiting Push can't be left waiting once dropping is allowed
+    m_spaceCondition.notify_all();
+}
+
+void GifEncoder::SetPaletteStep(int step)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_paletteStep = step > 0 ? step : 1;
+}
+
+void GifEncoder::SetBands(int bands)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bands = bands > 0 ? bands : 1;
+}
+
+GifEncoder::Stats GifEncoder::GetStats()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const double msPerTick = 1000.0 / static_cast<double>(m_frequency.QuadPart);
+
+    Stats stats{};
+    stats.queued = static_cast<int>(m_queue.size());
+    stats.capacity = static_cast<int>(m_capacity);
+    stats.encoded = m_encoded;
+    stats.dropped = m_dropped;
+    stats.lastEncodeMs = m_lastEncodeTicks * msPerTick;
+    stats.meanEncodeMs = m_encoded > 0 ? m_totalEncodeTicks * msPerTick / m_encoded : 0.0;
+    stats.meanLatencyMs = m_encoded > 0 ? m_totalLatencyTicks * msPerTick / m_encoded : 0.0;
+    stats.cacheHitRate = m_cacheLookups > 0 ? 100.0 * m_cacheHits / m_cacheLookups : 0.0;
+
+    return stats;
+}
@@ -0,0 +1,142 @@
+/*********************************************************************************************
+**
+**	File Name:		GifEncoder.h
+**	Description:	This is the header file that contains the thread that writes recorded
+**                  frames to the gif, fed by a bounded queue of frame copies so recording
+**                  doesn't hold up rendering
+**
+**	Author:			Clarke Needles
+**	Created:		10/17/2026
+**
+**********************************************************************************************/
+
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+#include <Windows.h>
+#include "Colour.h"
+#include "Gif.h"
+#include "ThreadPool.h"
+
+class GifEncoder
+{
+public:
+    // What Push does with a frame when the queue is full
+    enum class Policy
+    {
+        WAIT, // Hold up the caller until the encoder makes room, every frame is kept
+        DROP  // Leave the frame out of the gif, the caller never waits
+    };
+
+    struct Stats
+    {
+        int queued;      // Frames waiting to be encoded
+        int capacity;
+        int encoded;
+        int dropped;
+        double lastEncodeMs;
+        double meanEncodeMs;
+        double meanLatencyMs; // Push to written, queueing included
+        double cacheHitRate;  // Percent of palette lookups the colour cache answered
+    };
+
+private:
+    // Either the pixels, or (recording indexed) the colour table entries and their table
+    struct QueuedFrame
+    {
+        std::vector<Colour> pixels;
+        std::vector<uint8_t> indices;
+        GifPalette palette;
+        bool transparent;
+        LARGE_INTEGER pushed;
+    };
+
+    GifWriter m_writer{};
+    int m_width = 0, m_height = 0, m_delay = 0;
+
+    // Palettes are split from every m_paletteStep-th pixel, and frames compressed in m_bands bands,
+    // on the encoder's own pool so render waits never pick up its tasks
+    ThreadPool& m_pool;
+    int m_paletteStep = 1;
+    int m_bands = 1;
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_queueCondition; // A frame was queued (or stopping)
+    std::condition_variable m_spaceCondition; // A frame was taken off the queue
+
+    // Copies are pooled, frames come off the back of m_spare and go back once written
+    std::deque<QueuedFrame> m_queue;
+    std::vector<QueuedFrame> m_spare;
+    size_t m_capacity = 0;
+    Policy m_policy = Policy::WAIT;
+    bool m_stop = false;
+    bool m_recording = false;
+    bool m_indexed = false;
+
+    int m_encoded = 0;
+    int m_dropped = 0;
+    LONGLONG m_lastEncodeTicks = 0;
+    LONGLONG m_totalEncodeTicks = 0;
+    LONGLONG m_totalLatencyTicks = 0;
+    uint64_t m_cacheHits = 0;
+    uint64_t m_cacheLookups = 0;
+    LARGE_INTEGER m_frequency{};
+
+private:
+    // Thread body
+    void Loop();
+
+    // Waiting for (or giving up on) a free place in the queue, false if the frame is dropped
+    bool MakeRoom(std::unique_lock<std::mutex>& lock);
+
+    // A pooled frame to copy into, queued again with Queue
+    QueuedFrame TakeSpare();
+    void Queue(QueuedFrame&& frame, std::unique_lock<std::mutex>& lock);
+
+public:
+    explicit GifEncoder(ThreadPool& pool);
+
+    ~GifEncoder();
+
+    GifEncoder(const GifEncoder&) = delete;
+    GifEncoder& operator=(const GifEncoder&) = delete;
+
+    // Creating the gif and starting the encoder, capacity is how many frames may be queued
+    // Indexed recordings are fed colour table entries with PushIndexed and skip quantising
+    bool Begin(
+        const char* filename,
+        int width,
+        int height,
+        int delay,
+        int capacity,
+        bool indexed = false);
+
+    // Copying a frame onto the queue, false if it was dropped
+    bool Push(const Colour* pixels);
+
+    // Copying an indexed frame (one palette entry per pixel) and its palette onto the queue
+    // Transparent if entry 0 is free to mark the pixels that didn't change
+    bool PushIndexed(const uint8_t* indices, const GifPalette& palette, bool transparent);
+
+    // Writing whatever is still queued, then closing the gif
+    void End();
+
+    bool IsRecording();
+
+    bool IsIndexed();
+
+    void SetPolicy(Policy policy);
+
+    // Building each palette from every step-th pixel, picked up from the next frame written
+    void SetPaletteStep(int step);
+
+    // Compressing each frame in this many bands at once (1 for the whole frame on this thread)
+    void SetBands(int bands);
+
+    Stats GetStats();
+};
@@ -0,0 +1,103 @@
+/*********************************************************************************************
+**
+**	File Name:		RenderThread.cpp
+**	Description:	This is the file that contains the function definitions for the render
+**                  thread
+**
+**	Author:			Clarke Needles
+**	Created:		10/17/2026
+**
+**********************************************************************************************/
+
+#include "RenderThread.h"
+
+RenderThread::RenderThread(Frame frame)
+    : m_frame(std::move(frame))
+{
+    m_thread = std::thread(&RenderThread::Loop, this);
+}
+
+RenderThread::~RenderThread()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+
+        // Give up the frame in flight too
+        ++m_generation;
+    }
+    m_wakeCondition.notify_all();
+
+    m_thread.join();
+}
+
+void RenderThread::Loop()
+{
+    std::vector<ViewChange> changes;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wakeCondition.wait(lock, [this] { return m_stop || !m_changes.empty(); });
+
+            if (m_stop)
+            {
+                return;
+            }
+
+            // Everything queued goes into this one frame, a burst of wheel events is rendered once
+            changes.clear();
+            changes.swap(m_changes);
+            m_renderingGeneration = m_generation.load();
+            m_busy = true;
+        }
+
+        bool finished = m_frame(changes);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            finished ? ++m_finishedFrames : ++m_cancelledFrames;
+            m_busy = false;
+        }
+        m_idleCondition.notify_all();
+    }
+}
+
+void RenderThread::Submit(const ViewChange& change)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_changes.push_back(change);
+
+        // A recolour doesn't move the view, the frame in flight is still worth finishing
+        if (change.change != Change::RECOLOUR)
+        {
+            ++m_generation;
+        }
+    }
+    m_wakeCondition.notify_one();
+}
+
+bool RenderThread::IsStale() const
+{
+    return m_generation.load(std::memory_order_relaxed) != m_renderingGeneration.load(std::memory_order_relaxed);
+}
+
+void RenderThread::Wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idleCondition.wait(lock, [this] { return !m_busy && m_changes.empty(); });
+}
+
+int RenderThread::GetFinishedFrames()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_finishedFrames;
+}
+
+int RenderThread::GetCancelledFrames()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_cancelledFrames;
+}
@@ -0,0 +1,87 @@
+/*********************************************************************************************
+**
+**	File Name:		RenderThread.h
+**	Description:	This is the header file that contains the thread frames are rendered on,
+**                  away from the UI thread, with the queue of view changes it works through
+**
+**	Author:			Clarke Needles
+**	Created:		10/17/2026
+**
+**********************************************************************************************/
+
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+#include <Windows.h>
+
+class RenderThread
+{
+public:
+    enum class Change
+    {
+        GENERATE,
+        ZOOM_IN,
+        ZOOM_OUT,
+        MOVE,
+        RECOLOUR
+    };
+
+    struct ViewChange
+    {
+        Change change;
+        POINT point; // Where the click was, for MOVE
+    };
+
+    // Run on the render thread with every change queued since the last frame, in order
+    // Returns false if the frame was given up because a newer change came in
+    using Frame = std::function<bool(const std::vector<ViewChange>&)>;
+
+private:
+    Frame m_frame;
+    std::thread m_thread;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeCondition; // Changes queued (or stopping)
+    std::condition_variable m_idleCondition; // A frame finished or was given up
+    std::vector<ViewChange> m_changes;
+    bool m_busy = false;
+    bool m_stop = false;
+
+    // Every change that needs a new frame bumps the generation
+    // The frame in flight is stale as soon as it isn't the latest one any more
+    std::atomic<unsigned> m_generation{ 0 };
+    std::atomic<unsigned> m_renderingGeneration{ 0 };
+
+    int m_finishedFrames = 0;
+    int m_cancelledFrames = 0;
+
+private:
+    // Thread body
+    void Loop();
+
+public:
+    explicit RenderThread(Frame frame);
+
+    ~RenderThread();
+
+    RenderThread(const RenderThread&) = delete;
+    RenderThread& operator=(const RenderThread&) = delete;
+
+    // Queue a view change, a frame in flight is given up for it (unless it's only a recolour)
+    void Submit(const ViewChange& change);
+
+    // Polled by the frame between tiles
+    bool IsStale() const;
+
+    // Block until everything queued has been rendered
+    void Wait();
+
+    // Frames rendered to the end, and frames given up for newer changes
+    int GetFinishedFrames();
+    int GetCancelledFrames();
+};
@@ -24,13 +24,35 @@
 #define ID_RENDER_GENERATE              40019
 #define ID_RENDER_RECORD                40020
 #define ID_TEST                         40021
+#define ID_RENDER_STREAM                40022
+#define ID_RENDER_SUBDIVIDE             40023
+#define ID_LANGUAGE_AVX512              40024
+#define ID_LANGUAGE_AVX512_MT           40025
+#define ID_LANGUAGE_AUTO                40026
+#define ID_EXPONENT_2                   40027
+#define ID_EXPONENT_3                   40028
+#define ID_EXPONENT_4                   40029
+#define ID_EXPONENT_5                   40030
+#define ID_EXPONENT_6                   40031
+#define ID_EXPONENT_7                   40032
+#define ID_EXPONENT_8                   40033
+#define ID_EXPONENT_1_5                 40034
+#define ID_EXPONENT_2_5                 40035
+#define ID_EXPONENT_3_5                 40036
+#define ID_EXPONENT_4_5                 40037
+#define ID_RENDER_REUSE                 40038
+#define ID_RENDER_PROGRESSIVE           40039
+#define ID_RENDER_GIF_DROP              40040
+#define ID_RENDER_GIF_SAMPLE            40041
+#define ID_RENDER_GIF_INDEXED           40042
+#define ID_RENDER_GIF_BANDS             40043
 
 // Next default values for new objects
 // 
 #ifdef APSTUDIO_INVOKED
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_NEXT_RESOURCE_VALUE        105
-#define _APS_NEXT_COMMAND_VALUE         40022
+#define _APS_NEXT_COMMAND_VALUE         40044
 #define _APS_NEXT_CONTROL_VALUE         1001
 #define _APS_NEXT_SYMED_VALUE           101
 #endif
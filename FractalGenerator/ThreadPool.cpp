@@ -0,0 +1,203 @@
+/*********************************************************************************************
+**
+**	File Name:		ThreadPool.cpp
+**	Description:	This is the file that contains the function definitions for the work
+**                  stealing thread pool
+**
+**	Author:			Clarke Needles
+**	Created:		10/17/2026
+**
+**********************************************************************************************/
+
+#include "ThreadPool.h"
+
+#include <chrono>
+
+// Which pool (and which queue in it) the current thread belongs to
+static thread_local const ThreadPool* t_pool = nullptr;
+static thread_local int t_workerIndex = -1;
+
+ThreadPool::ThreadPool(unsigned numThreads)
+{
+    // hardware_concurrency is allowed to return 0
+    if (numThreads == 0)
+    {
+        numThreads = 1;
+    }
+
+    for (unsigned i = 0; i < numThreads; ++i)
+    {
+        m_queues.emplace_back(std::make_unique<WorkQueue>());
+    }
+
+    // Queues must all exist before any worker starts stealing
+    for (unsigned i = 0; i < numThreads; ++i)
+    {
+        m_threads.emplace_back(&ThreadPool::WorkerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_stop = true;
+    }
+    m_wakeCondition.notify_all();
+
+    for (auto& t : m_threads)
+    {
+        t.join();
+    }
+}
+
+int ThreadPool::GetWorkerIndex() const
+{
+    return t_pool == this ? t_workerIndex : -1;
+}
+
+void ThreadPool::Submit(Task task)
+{
+    int index = GetWorkerIndex();
+    if (index < 0)
+    {
+        // Outside threads (the UI thread) deal the tasks out round robin
+        index = static_cast<int>(m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_queues.size());
+    }
+
+    {
+        WorkQueue& queue = *m_queues[index];
+        std::lock_guard<std::mutex> lock(queue.m_mutex);
+        queue.m_tasks.push_back(std::move(task));
+    }
+
+    // Lock before notifying so a worker can't miss the wake up between its check and its wait
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        ++m_queuedTasks;
+    }
+    m_wakeCondition.notify_one();
+}
+
+bool ThreadPool::TryPop(unsigned index, Task& task)
+{
+    WorkQueue& queue = *m_queues[index];
+    std::lock_guard<std::mutex> lock(queue.m_mutex);
+
+    if (queue.m_tasks.empty())
+    {
+        return false;
+    }
+
+    task = std::move(queue.m_tasks.back());
+    queue.m_tasks.pop_back();
+    --m_queuedTasks;
+
+    return true;
+}
+
+bool ThreadPool::TrySteal(unsigned thief, Task& task)
+{
+    const unsigned numQueues = static_cast<unsigned>(m_queues.size());
+
+    // Start with the neighbour so thieves don't all hammer queue 0
+    for (unsigned i = 1; i <= numQueues; ++i)
+    {
+        WorkQueue& queue = *m_queues[(thief + i) % numQueues];
+        std::lock_guard<std::mutex> lock(queue.m_mutex);
+
+        if (!queue.m_tasks.empty())
+        {
+            task = std::move(queue.m_tasks.front());
+            queue.m_tasks.pop_front();
+            --m_queuedTasks;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool ThreadPool::RunPendingTask()
+{
+    Task task;
+    int index = GetWorkerIndex();
+
+    if ((index >= 0 && TryPop(index, task)) ||
+        TrySteal(index >= 0 ? index : 0, task))
+    {
+        task();
+        return true;
+    }
+
+    return false;
+}
+
+void ThreadPool::WorkerLoop(unsigned index)
+{
+    t_pool = this;
+    t_workerIndex = static_cast<int>(index);
+
+    while (true)
+    {
+        Task task;
+        if (TryPop(index, task) || TrySteal(index, task))
+        {
+            task();
+            continue;
+        }
+
+        // Nothing to do, sleep until something is queued
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_wakeCondition.wait(lock, [this] { return m_stop || m_queuedTasks > 0; });
+
+        if (m_stop)
+        {
+            break;
+        }
+    }
+}
+
+unsigned ThreadPool::GetNumThreads() const
+{
+    return static_cast<unsigned>(m_threads.size());
+}
+
+void TaskGroup::Run(ThreadPool::Task task)
+{
+    ++m_pending;
+
+    m_pool.Submit([this, task = std::move(task)]
+    {
+        task();
+
+        // Last task out wakes the waiter
+        // Done under the lock so the group can't be destroyed while we still touch it
+        std::lock_guard<std::mutex> lock(m_doneMutex);
+        if (--m_pending == 0)
+        {
+            m_doneCondition.notify_all();
+        }
+    });
+}
+
+void TaskGroup::Wait()
+{
+    while (m_pending > 0)
+    {
+        // Help instead of blocking, this is what lets a task wait on a nested group
+        if (m_pool.RunPendingTask())
+        {
+            continue;
+        }
+
+        // The remaining tasks are running elsewhere
+        // Wake up now and then in case one of them queues more work
+        std::unique_lock<std::mutex> lock(m_doneMutex);
+        m_doneCondition.wait_for(lock, std::chrono::microseconds(200), [this] { return m_pending == 0; });
+    }
+
+    // Make sure the last task has let go of the mutex before the caller moves on
+    std::lock_guard<std::mutex> lock(m_doneMutex);
+}
@@ -0,0 +1,107 @@
+/*********************************************************************************************
+**
+**	File Name:		ThreadPool.h
+**	Description:	This is the header file that contains the long-lived work stealing
+**                  thread pool used for rendering (threads are reused across frames)
+**
+**	Author:			Clarke Needles
+**	Created:		10/17/2026
+**
+**********************************************************************************************/
+
+#pragma once
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+class ThreadPool
+{
+public:
+    using Task = std::function<void()>;
+
+private:
+    // Each worker owns a deque
+    // The owner pushes/pops at the back, thieves steal from the front
+    struct WorkQueue
+    {
+        std::mutex m_mutex;
+        std::deque<Task> m_tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+    std::vector<std::thread> m_threads;
+
+    // Sleeping workers wait here until a task is queued
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCondition;
+
+    std::atomic<int> m_queuedTasks{ 0 };
+    std::atomic<unsigned> m_nextQueue{ 0 };
+    std::atomic<bool> m_stop{ false };
+
+private:
+    // Worker thread body
+    void WorkerLoop(unsigned index);
+
+    // Pop from the back of our own deque
+    bool TryPop(unsigned index, Task& task);
+
+    // Steal from the front of any other deque
+    bool TrySteal(unsigned thief, Task& task);
+
+    // Index of the calling thread's queue in this pool, -1 for outside threads
+    int GetWorkerIndex() const;
+
+public:
+    explicit ThreadPool(unsigned numThreads = std::thread::hardware_concurrency());
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Queue a task. Workers push onto their own deque, other threads spread round robin
+    void Submit(Task task);
+
+    // Run one queued task on the calling thread, returns false if there was nothing to run
+    bool RunPendingTask();
+
+    unsigned GetNumThreads() const;
+};
+
+// A batch of tasks that can be waited on
+// The waiting thread helps out by running queued tasks, so groups can be nested
+class TaskGroup
+{
+private:
+    ThreadPool& m_pool;
+
+    std::atomic<int> m_pending{ 0 };
+    std::mutex m_doneMutex;
+    std::condition_variable m_doneCondition;
+
+public:
+    explicit TaskGroup(ThreadPool& pool) : m_pool(pool)
+    {
+    }
+
+    ~TaskGroup()
+    {
+        Wait();
+    }
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    // Add a task to the group and submit it to the pool
+    void Run(ThreadPool::Task task);
+
+    // Block until every task in the group has finished
+    void Wait();
+};